@@ -0,0 +1,111 @@
+// Modern C++17 SO Loader - Per-Library Arena Allocator (arm64 only)
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace soloader {
+
+// 同时存在的 arena 数上限（每个槽位对应一组独立实例化的分配函数）
+inline constexpr size_t kMaxArenas = 16;
+
+struct ArenaStats {
+    size_t allocations = 0;         // 分配次数（含 calloc/realloc/operator new）
+    size_t frees = 0;
+    size_t bytes_in_use = 0;        // 按块大小计
+    size_t peak_bytes = 0;
+    size_t reserved_bytes = 0;      // 已映射的 chunk 与大块分配
+    size_t large_allocations = 0;   // 超过最大小块规格、直接走系统 malloc 的分配
+};
+
+// 单个库专用的分配器：库的 malloc/calloc/realloc/free/operator new/delete 导入在重定位时
+// 绑定到本 arena。小块按规格从 1MB chunk 切分，线程本地缓存无锁分配/释放；
+// 销毁时整体释放，不依赖库自行释放全部内存。
+// 非本 arena 分配的指针（如 libc 的 strdup 结果）在 free/realloc 时转交系统分配器；
+// 反过来，本 arena 的指针不能交给系统库释放
+class PluginArena {
+public:
+    // 占用一个空闲槽位，槽位用尽返回 nullptr
+    static std::unique_ptr<PluginArena> create();
+    ~PluginArena();
+
+    PluginArena(const PluginArena&) = delete;
+    PluginArena& operator=(const PluginArena&) = delete;
+
+    // 供链接器绑定的分配函数（符号名 → 本槽位的实现）
+    const std::vector<std::pair<std::string_view, void*>>& overrides() const;
+
+    // 各线程的小块计数按批汇总（每线程最多滞后一批），调用线程自身的计数在读取时合并
+    ArenaStats stats();
+
+    void* allocate(size_t size);
+    void* allocateZeroed(size_t count, size_t size);
+    void* reallocate(void* ptr, size_t size);
+    void deallocate(void* ptr);
+    size_t usableSize(const void* ptr) const;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static constexpr size_t kChunkSize = 1 << 20;
+    static constexpr size_t kPageSize = 64 << 10;           // 每页只切一种规格
+    static constexpr size_t kPagesPerChunk = kChunkSize / kPageSize;
+    static constexpr size_t kChunkSlots = 2048;             // 开放寻址，最多使用一半
+    static constexpr size_t kSizeClasses = 24;
+    static constexpr size_t kMaxSmallSize = 2048;
+
+    struct ChunkEntry {
+        std::atomic<uintptr_t> base{0};
+        uint8_t page_class[kPagesPerChunk] = {};
+    };
+
+    struct ThreadCache;
+    struct ThreadCaches;
+
+    explicit PluginArena(uint64_t epoch);
+
+    ThreadCache& threadCache();
+
+    const ChunkEntry* findChunk(const void* ptr) const;
+    FreeBlock* refillLocked(size_t cls, size_t* count);
+    bool newPageLocked(size_t cls);
+    bool newChunkLocked();
+    void* allocateLarge(size_t size);
+    void deallocateForeign(void* ptr);
+    void noteAlloc(size_t bytes);
+    void noteFree(size_t bytes);
+    void flushStats(ThreadCache& tc);
+    void releaseThreadCache(ThreadCache& tc);
+
+    size_t slot_ = 0;
+    uint64_t epoch_;        // 线程缓存据此丢弃已销毁 arena 的残留链表
+
+    mutable std::mutex mutex_;
+    FreeBlock* free_lists_[kSizeClasses] = {};
+    uintptr_t page_cursor_[kSizeClasses] = {};
+    uintptr_t page_end_[kSizeClasses] = {};
+    ChunkEntry* current_chunk_ = nullptr;
+    size_t next_page_ = kPagesPerChunk;
+    size_t chunk_count_ = 0;
+    std::unique_ptr<ChunkEntry[]> chunks_;
+    std::unordered_map<void*, size_t> large_;
+
+    std::atomic<size_t> large_count_{0};
+    std::atomic<size_t> allocations_{0};
+    std::atomic<size_t> frees_{0};
+    std::atomic<size_t> bytes_in_use_{0};
+    std::atomic<size_t> peak_bytes_{0};
+    std::atomic<size_t> reserved_bytes_{0};
+    std::atomic<size_t> large_allocations_{0};
+};
+
+} // namespace soloader
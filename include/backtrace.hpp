@@ -8,7 +8,7 @@
 
 namespace soloader {
 
-constexpr size_t MAX_CUSTOM_LIBS = 64;
+constexpr size_t MAX_CUSTOM_LIBS = 512;
 
 class BacktraceManager {
 public:
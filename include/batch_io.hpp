@@ -0,0 +1,47 @@
+// Modern C++17 SO Loader - Batched I/O (arm64 only)
+#pragma once
+
+#include "load_context.hpp"
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+
+namespace soloader {
+
+class IoRing;
+
+// 批量 I/O：一次提交完成一组库（整层依赖）的打开 + 读取，路径由 LibrarySearchPath 解析。
+// io_uring 后端按批提交（打开/fstat/读取各 1 次），
+// 内核不支持或被 seccomp/SELinux 拦截时回退同步实现
+class BatchIo {
+public:
+    enum class Backend {
+        Sync,
+        IoUring,
+    };
+
+    static BatchIo& instance();
+
+    // 打开、fstat 并读取整个文件；失败项的 contexts[i].isOpen() 为 false
+    void openAndRead(const std::vector<std::string>& paths,
+                     std::vector<LoadContext>& contexts);
+
+    // 切换后端；请求 io_uring 但不可用时保持同步实现并返回 false
+    bool setBackend(Backend backend);
+    Backend backend() const;
+
+private:
+    BatchIo();
+    ~BatchIo();
+
+    bool openAndReadUring(const std::vector<std::string>& paths,
+                          std::vector<LoadContext>& contexts);
+    void openAndReadSync(const std::vector<std::string>& paths,
+                         std::vector<LoadContext>& contexts);
+
+    mutable std::mutex mutex_;
+    std::unique_ptr<IoRing> ring_;
+};
+
+} // namespace soloader
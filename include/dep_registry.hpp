@@ -0,0 +1,75 @@
+// Modern C++17 SO Loader - Shared Dependency Registry (arm64 only)
+#pragma once
+
+#include "elf_image.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+
+namespace soloader {
+
+struct TlsIndex;
+
+// 进程内共享的手动加载依赖：已完成重定位，映射与镜像由注册表持有。
+// 登记方推迟了构造函数时，由第一个需要它的链接器在 init_mutex 下补做构造
+struct SharedDependency {
+    std::shared_ptr<ElfImage> image;
+    void* map_base = nullptr;
+    size_t map_size = 0;
+    dev_t dev = 0;
+    ino_t ino = 0;
+    std::string build_id;
+    std::vector<TlsIndex*> tls_indices;             // 其 TLSDESC 重定位分配的描述符
+    std::vector<SharedDependency*> providers;       // 其绑定引用的其他共享依赖（各持有一个引用）
+    size_t refs = 0;
+    std::mutex init_mutex;
+    bool constructed = false;                       // 未构造的副本卸载时也不执行析构函数
+};
+
+// 进程级手动加载依赖注册表，按文件身份（dev/inode）索引并校验 build-id。
+// 后续链接器直接复用已链接的副本（不再映射、重定位，构造函数只执行一次），
+// 最后一个引用释放时由调用方析构并卸载。没有 build-id 的库不参与共享
+class DependencyRegistry {
+public:
+    static DependencyRegistry& instance();
+
+    // 文件身份和 build-id 都一致时增加引用并返回已链接的副本，否则返回 nullptr
+    SharedDependency* acquire(const struct stat& st, std::string_view build_id);
+
+    // 登记刚完成链接的依赖，每项初始持有调用方的一个引用。同一文件已被登记（并发链接）的项，
+    // 以及依赖这些项的项留在 batch 中由调用方继续私有持有；登记成功的项从 batch 中移出
+    void publish(std::vector<std::unique_ptr<SharedDependency>>& batch);
+
+    // 释放一个引用；引用归零的项（连同因此归零的 providers）按析构顺序追加到 out，
+    // 由调用方在锁外执行析构函数并解除映射
+    void release(SharedDependency* dep, std::vector<std::unique_ptr<SharedDependency>>& out);
+
+    size_t size() const;
+
+private:
+    DependencyRegistry() = default;
+
+    struct FileKey {
+        dev_t dev;
+        ino_t ino;
+        bool operator==(const FileKey& o) const { return dev == o.dev && ino == o.ino; }
+    };
+    struct FileKeyHash {
+        size_t operator()(const FileKey& k) const {
+            return std::hash<uint64_t>()(static_cast<uint64_t>(k.dev) * 0x9e3779b97f4a7c15ULL ^ k.ino);
+        }
+    };
+
+    void releaseLocked(SharedDependency* dep, std::vector<std::unique_ptr<SharedDependency>>& out);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<FileKey, std::unique_ptr<SharedDependency>, FileKeyHash> entries_;
+};
+
+} // namespace soloader
@@ -6,8 +6,14 @@
 #include <string_view>
 #include <optional>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <iterator>
 #include <elf.h>
+#include <fnmatch.h>
 #include <link.h>
+#include <sys/stat.h>
 
 namespace soloader {
 
@@ -48,6 +54,89 @@ struct SymbolInfo {
     bool isWeak() const { return bind == STB_WEAK; }
 };
 
+// 已定义且非局部的 .dynsym 符号（导出符号）
+inline bool isExportedSymbol(const ElfSym& sym) {
+    return sym.st_name && sym.st_shndx != SHN_UNDEF && elf_st_bind(sym.st_info) != STB_LOCAL;
+}
+
+// 文件镜像中 NT_GNU_BUILD_ID 注释的内容（原始字节），没有时为空
+std::string_view findBuildId(const ElfEhdr* header, size_t file_size);
+
+// 导出符号视图：name 直接指向 .dynstr（以 '\0' 结尾），不做拷贝
+struct ExportedSymbol {
+    std::string_view name;
+    const ElfSym* sym = nullptr;
+};
+
+// 导出符号区间。order 为空时顺序遍历 .dynsym 并跳过非导出项，
+// 否则按 order 中的 dynsym 下标遍历（如按名字排序后的前缀区间）
+class ExportRange {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = ExportedSymbol;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = ExportedSymbol;
+
+        ExportedSymbol operator*() const {
+            const ElfSym* sym = dynsym_ + (order_ ? order_[pos_] : pos_);
+            return {strtab_ + sym->st_name, sym};
+        }
+        iterator& operator++() {
+            ++pos_;
+            skip();
+            return *this;
+        }
+        bool operator==(const iterator& o) const { return pos_ == o.pos_; }
+        bool operator!=(const iterator& o) const { return pos_ != o.pos_; }
+
+    private:
+        friend class ExportRange;
+        iterator(const ElfSym* dynsym, const char* strtab, const uint32_t* order, size_t pos, size_t end)
+            : dynsym_(dynsym), strtab_(strtab), order_(order), pos_(pos), end_(end) { skip(); }
+
+        void skip() {
+            if (order_) return;
+            while (pos_ < end_ && !isExportedSymbol(dynsym_[pos_])) ++pos_;
+        }
+
+        const ElfSym* dynsym_;
+        const char* strtab_;
+        const uint32_t* order_;
+        size_t pos_;
+        size_t end_;
+    };
+
+    ExportRange() = default;
+    ExportRange(const ElfSym* dynsym, const char* strtab, const uint32_t* order, size_t begin, size_t end)
+        : dynsym_(dynsym), strtab_(strtab), order_(order), begin_(begin), end_(end) {}
+
+    iterator begin() const { return iterator(dynsym_, strtab_, order_, begin_, end_); }
+    iterator end() const { return iterator(dynsym_, strtab_, order_, end_, end_); }
+    bool empty() const { return begin() == end(); }
+
+private:
+    const ElfSym* dynsym_ = nullptr;
+    const char* strtab_ = nullptr;
+    const uint32_t* order_ = nullptr;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+};
+
+class LoadContext;
+class ExportIndex;
+
+// arm64 IFUNC 解析器参数（hwcap 进程内只读取一次）
+struct IfuncArg {
+    unsigned long size;
+    unsigned long hwcap;
+    unsigned long hwcap2;
+};
+const IfuncArg& ifuncArg();
+ElfAddr callIfuncResolver(uintptr_t resolver);
+
 using InitFunc = void(*)();
 using CtorFunc = void(*)(int, char**, char**);
 using DtorFunc = void(*)();
@@ -59,14 +148,80 @@ public:
     ElfImage& operator=(ElfImage&&) noexcept;
     
     static std::unique_ptr<ElfImage> create(std::string_view path, void* base = nullptr);
+    // 复用加载上下文中已打开的 fd 和文件镜像，不再重复打开文件
+    static std::unique_ptr<ElfImage> create(LoadContext& ctx, void* base);
+    // 仅解析文件（不要求已加载或映射，供离线工具使用），运行时地址相关字段为空
+    static std::unique_ptr<ElfImage> parseFile(std::string_view path);
     
     // 符号查找
     std::optional<ElfAddr> findSymbolOffset(std::string_view name, uint8_t* type = nullptr, uint8_t* bind = nullptr) const;
     std::optional<ElfAddr> findSymbolAddress(std::string_view name, uint8_t* bind = nullptr) const;
+    // 使用预先计算的 gnuHash（如编译期计算），省去逐字符哈希
+    std::optional<ElfAddr> findSymbolOffset(std::string_view name, uint32_t gnu_hash, uint8_t* type, uint8_t* bind) const;
+    std::optional<ElfAddr> findSymbolAddress(std::string_view name, uint32_t gnu_hash, uint8_t* bind) const;
     SymbolInfo getSymbolAt(uintptr_t addr) const;
+    // 符号在内存中的地址（处理 IFUNC），未映射时返回 0
+    ElfAddr symbolAddress(const ElfSym& sym) const;
+    
+    // 按 .dynsym 顺序遍历全部导出符号，不分配内存
+    ExportRange exports() const;
+    // 名字以 prefix 开头的导出符号，按名字排序；首次调用时建立排序索引，之后为两次二分查找
+    ExportRange exportsWithPrefix(std::string_view prefix) const;
+    // 名字匹配 glob 模式（fnmatch 语法）的导出符号：按模式的字面前缀缩小范围后逐个匹配
+    template<typename Fn>
+    size_t forEachExport(std::string_view pattern, Fn&& fn) const {
+        std::string pat(pattern);
+        size_t matched = 0;
+        for (auto sym : exportsWithPrefix(pattern.substr(0, pattern.find_first_of("*?[\\")))) {
+            if (fnmatch(pat.c_str(), sym.name.data(), 0) != 0) continue;
+            fn(sym);
+            matched++;
+        }
+        return matched;
+    }
+    
+    // 遍历精确查找可能命中的全部名字（.dynsym 中已定义的符号，以及 .symtab 中的函数/对象），
+    // 无法完整枚举（缺少 .dynsym 节区信息）时返回 false
+    template<typename Fn>
+    bool forEachDefinedName(Fn&& fn) const {
+        size_t count = dynsymCount();
+        if (!count) return false;
+        for (size_t i = 1; i < count; i++) {
+            auto& sym = dynsym_start_[i];
+            if (sym.st_name && sym.st_shndx != SHN_UNDEF) fn(std::string_view(strtab_start_ + sym.st_name));
+        }
+        for (size_t i = 0; symtab_strtab_ && i < symtab_count_; i++) {
+            auto& sym = symtab_start_[i];
+            uint8_t st = elf_st_type(sym.st_info);
+            if ((st == STT_FUNC || st == STT_OBJECT) && sym.st_size > 0 && sym.st_shndx != SHN_UNDEF)
+                fn(std::string_view(symtab_strtab_ + sym.st_name));
+        }
+        return true;
+    }
+    
+    // 遍历 .dynsym 中的未定义符号（导入），缺少 .dynsym 节区信息时返回 false
+    template<typename Fn>
+    bool forEachImportedName(Fn&& fn) const {
+        size_t count = dynsymCount();
+        if (!count) return false;
+        for (size_t i = 1; i < count; i++) {
+            auto& sym = dynsym_start_[i];
+            if (sym.st_name && sym.st_shndx == SHN_UNDEF) fn(std::string_view(strtab_start_ + sym.st_name));
+        }
+        return true;
+    }
+    
+    // 导出符号数不少于 min_exports 时构建完美哈希导出表，之后命中导出的精确查找只需一次探测；
+    // 未命中仍回退到 .symtab 线性扫描
+    bool buildExportIndex(size_t min_exports);
+    const ExportIndex* exportIndex() const { return export_index_.get(); }
+    
+    // 调用本镜像中的 IFUNC 解析器，结果按解析器地址缓存（符号查找与 IRELATIVE 共用）
+    ElfAddr resolveIfunc(uintptr_t resolver) const;
 
     // Getters
     const std::string& path() const { return path_; }
+    std::string_view buildId() const { return findBuildId(header_, file_size_); }
     void* base() const { return base_; }
     ElfEhdr* header() const { return header_; }
     ptrdiff_t bias() const { return bias_; }
@@ -95,12 +250,16 @@ public:
 private:
     ElfImage() = default;
     bool init(std::string_view path, void* base);
+    bool init(LoadContext& ctx, void* base);
+    bool locateBase(void* base, const struct stat* st);
+    bool adoptImage(LoadContext& ctx);
     bool parseHeaders();
     bool parseDynamic();
     
     std::optional<ElfAddr> gnuHashLookup(std::string_view name, uint32_t hash, uint8_t* type, uint8_t* bind) const;
     std::optional<ElfAddr> elfHashLookup(std::string_view name, uint32_t hash, uint8_t* type, uint8_t* bind) const;
     std::optional<ElfAddr> linearLookup(std::string_view name, uint8_t* type, uint8_t* bind) const;
+    size_t dynsymCount() const;
 
     std::string path_;
     void* base_ = nullptr;
@@ -147,9 +306,37 @@ private:
     size_t eh_frame_size_ = 0;
     const uint8_t* eh_frame_hdr_ = nullptr;
     size_t eh_frame_hdr_size_ = 0;
+    
+    std::unique_ptr<ExportIndex> export_index_;
+    
+    // 按名字排序的导出符号下标（前缀查询时惰性建立，建立后不再修改）
+    mutable std::mutex sorted_exports_mutex_;
+    mutable bool sorted_exports_built_ = false;
+    mutable std::vector<uint32_t> sorted_exports_;
+    
+    // IFUNC 解析结果缓存
+    mutable std::mutex ifunc_mutex_;
+    mutable std::unordered_map<uintptr_t, ElfAddr> ifunc_cache_;
 };
 
-uint32_t elfHash(std::string_view name);
-uint32_t gnuHash(std::string_view name);
+// 符号哈希（constexpr，可在编译期预计算）
+constexpr uint32_t elfHash(std::string_view name) {
+    uint32_t h = 0;
+    for (char c : name) {
+        h = (h << 4) + static_cast<uint8_t>(c);
+        uint32_t g = h & 0xf0000000;
+        if (g) h ^= g >> 24;
+        h &= ~g;
+    }
+    return h;
+}
+
+constexpr uint32_t gnuHash(std::string_view name) {
+    uint32_t h = 5381;
+    for (char c : name) {
+        h = (h << 5) + h + static_cast<uint8_t>(c);
+    }
+    return h;
+}
 
 } // namespace soloader
@@ -0,0 +1,51 @@
+// Modern C++17 SO Loader - Epoch-Based Reclamation (arm64 only)
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace soloader {
+
+// 进程级纪元回收：读者进入时在线程记录中登记当前纪元，离开时清零，全程只有两次原子存储
+// 和一次内存屏障，不加锁。写者先撤下共享对象，再调用 synchronize() 推进纪元并等待
+// 此前进入的读者全部离开，之后即可安全释放（munmap、析构等）。
+// 读者可嵌套；读者内部不能调用 synchronize()，否则会等待自身
+class EpochDomain {
+public:
+    static EpochDomain& instance();
+
+    class Guard {
+    public:
+        Guard();
+        ~Guard();
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    // 阻塞到调用前已进入的读者全部离开
+    void synchronize();
+
+private:
+    EpochDomain() = default;
+
+    struct alignas(64) Record {
+        std::atomic<uint64_t> epoch{0};     // 0 表示不在读者区内
+        std::atomic<bool> in_use{false};
+        Record* next = nullptr;
+    };
+
+    struct ThreadState;
+
+    static ThreadState& threadState();
+    void enter();
+    void leave();
+    Record* acquireRecord();
+
+    std::atomic<uint64_t> epoch_{1};
+    std::atomic<Record*> records_{nullptr};     // 只增不减，线程退出后记录复用
+    std::mutex sync_mutex_;
+};
+
+} // namespace soloader
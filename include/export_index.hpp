@@ -0,0 +1,49 @@
+// Modern C++17 SO Loader - Perfect-Hash Export Index (arm64 only)
+#pragma once
+
+#include "elf_image.hpp"
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace soloader {
+
+// 导出符号的最小完美哈希（CHD：hash-and-displace），直接建立在 gnuHash 之上，
+// 预先计算哈希的查找（bindSymbols）无需再遍历字符串。每个桶记录一个位移 d，
+// 使桶内符号的 mix(h ^ d) 落在互不相同的槽位；查找为一次槽位读取加一次字符串比较，没有链表遍历
+class ExportIndex {
+public:
+    struct Stats {
+        size_t symbols = 0;
+        size_t buckets = 0;
+        size_t bytes = 0;           // 位移表、槽位表与溢出表占用
+        double build_ms = 0;
+    };
+
+    // 收集 dynsym 中已定义的全局/弱符号并构建；符号表不可用或构建失败返回 nullptr
+    static std::unique_ptr<ExportIndex> build(const ElfSym* dynsym, size_t count, const char* strtab);
+
+    // 导出符号数（构建前用于判断是否值得启用）
+    static size_t countExports(const ElfSym* dynsym, size_t count);
+
+    // 返回 dynsym 下标，未导出返回 0（STN_UNDEF）
+    uint32_t find(std::string_view name, uint32_t gnu_hash) const;
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    ExportIndex() = default;
+
+    const ElfSym* dynsym_ = nullptr;
+    const char* strtab_ = nullptr;
+    uint64_t seed_ = 0;
+    uint32_t size_ = 0;
+    std::vector<uint32_t> displacement_;    // 每个桶的位移
+    std::vector<uint32_t> slots_;           // 槽位 → dynsym 下标
+    std::vector<std::pair<uint32_t, uint32_t>> overflow_;   // gnuHash 重复的符号（哈希, 下标）
+    Stats stats_;
+};
+
+} // namespace soloader
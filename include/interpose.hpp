@@ -0,0 +1,37 @@
+// Modern C++17 SO Loader - Symbol Interposition Table (arm64 only)
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
+
+namespace soloader {
+
+// 进程级符号替换表：名字 → 替换地址，按 gnuHash 索引，在符号解析时优先于所有镜像和系统库。
+// 默认包含 dl_iterate_phdr 和 dladdr（使手动加载的库对回溯可见），也可注册自己的
+// malloc、日志或系统调用垫片。只影响此后的链接，已完成的绑定不会改写
+class InterposeTable {
+public:
+    static InterposeTable& instance();
+
+    // 注册或替换一项；replacement 为 nullptr 时等同于 remove
+    void add(std::string_view name, void* replacement);
+    bool remove(std::string_view name);
+
+    // 未注册返回 nullptr。大多数名字只需检查一个原子位图即可排除，不加锁
+    void* find(std::string_view name, uint32_t gnu_hash) const;
+
+private:
+    InterposeTable();
+
+    void rebuildFilterLocked();
+
+    mutable std::mutex mutex_;
+    std::unordered_multimap<uint32_t, std::pair<std::string, void*>> entries_;   // gnuHash → (名字, 地址)
+    std::atomic<uint64_t> filter_{0};     // 已注册名字的 gnuHash 低 6 位
+};
+
+} // namespace soloader
@@ -0,0 +1,55 @@
+// Modern C++17 SO Loader - Library Namespace (arm64 only)
+#pragma once
+
+#include "elf_image.hpp"
+#include "linker.hpp"
+#include "symbol_cache.hpp"
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace soloader {
+
+// 多个库共享一个链接作用域：同一份依赖集合、符号作用域过滤器和符号缓存，
+// 每批库的依赖加载、TLS 注册、重定位和回溯注册整批完成。
+// 后加载的库可以解析到先加载的库（如同 RTLD_GLOBAL），先加载的库已完成的绑定不变。
+// 50 个插件只需一个命名空间，而不是 50 个各自加载依赖的 SoLoader
+class LibraryNamespace {
+public:
+    LibraryNamespace() = default;
+    ~LibraryNamespace();
+
+    LibraryNamespace(const LibraryNamespace&) = delete;
+    LibraryNamespace& operator=(const LibraryNamespace&) = delete;
+
+    // 把一批库加载到作用域末尾，构造函数按先依赖后库的顺序执行。
+    // 已在命名空间中的路径跳过；任一库映射或依赖加载失败时整批不加载
+    bool load(const std::vector<std::string>& paths);
+    bool load(std::string_view path) { return load(std::vector<std::string>{std::string(path)}); }
+
+    // 按加载逆序析构并卸载全部库及其依赖
+    bool unload();
+
+    // 在整个作用域（全部库、依赖、系统库）中查找；命中缓存时无锁，可与 load/unload 并发
+    void* getSymbol(std::string_view name);
+
+    template<typename T>
+    T getSymbol(std::string_view name) {
+        return reinterpret_cast<T>(getSymbol(name));
+    }
+
+    // 只在指定库（完整路径或文件名）的导出中查找
+    void* getSymbol(std::string_view library, std::string_view name);
+
+    size_t libraryCount() const;
+    bool isLoaded() const;
+
+private:
+    mutable std::mutex mutex_;          // 串行化 load/unload 与缓存未命中的查找
+    Linker linker_;
+    std::vector<ElfImage*> libraries_;  // 显式加载的库，按加载顺序
+    SymbolCache cache_;
+};
+
+} // namespace soloader
@@ -0,0 +1,73 @@
+// Modern C++17 SO Loader - Process Link Map Snapshot (arm64 only)
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <sys/stat.h>
+
+namespace soloader {
+
+// 进程已加载模块的快照：一次 dl_iterate_phdr 遍历建立路径、文件身份（dev/inode）
+// 和 soname 三个索引，"是否已被系统加载" 的判断为 O(1) 精确匹配。
+// 通过 dlpi_adds/dlpi_subs 增量刷新：计数未变则不遍历，只有新增时只处理新模块；
+// 系统不提供计数时先比较模块加载地址列表，未变化则保留快照
+class LinkMap {
+public:
+    static LinkMap& instance();
+
+    // 与进程当前状态同步（每次链接开始时调用一次）
+    void refresh();
+
+    // 按完整路径查找，路径未命中时按文件身份（st 非空）查找，返回模块的 dlpi_addr
+    void* findBase(std::string_view path, const struct stat* st = nullptr) const;
+
+    // 按 soname（无 DT_SONAME 时为文件名）查找，out_path 返回模块路径
+    void* findSoname(std::string_view soname, std::string* out_path = nullptr) const;
+
+    // 快照每次发生变化（模块增减或整表重建）时递增，供依赖快照的缓存失效
+    uint64_t generation() const;
+
+private:
+    LinkMap() = default;
+
+    struct Module {
+        std::string path;       // dlpi_name
+        std::string soname;
+        void* base = nullptr;   // dlpi_addr
+        dev_t dev = 0;
+        ino_t ino = 0;
+    };
+
+    struct FileKey {
+        dev_t dev;
+        ino_t ino;
+        bool operator==(const FileKey& o) const { return dev == o.dev && ino == o.ino; }
+    };
+    struct FileKeyHash {
+        size_t operator()(const FileKey& k) const {
+            return std::hash<uint64_t>()(static_cast<uint64_t>(k.dev) * 0x9e3779b97f4a7c15ULL ^ k.ino);
+        }
+    };
+
+    void addModule(Module module);
+    bool sameModulesLocked() const;
+
+    mutable std::mutex mutex_;
+    bool valid_ = false;                // 快照可按 dlpi_adds/dlpi_subs 增量刷新
+    bool snapshot_taken_ = false;
+    std::vector<uintptr_t> bases_;      // 按链表顺序的加载地址（无计数时作为指纹）
+    uint64_t generation_ = 0;
+    unsigned long long adds_ = 0;
+    unsigned long long subs_ = 0;
+    std::vector<Module> modules_;
+    std::unordered_map<std::string, size_t> by_path_;
+    std::unordered_map<std::string, size_t> by_soname_;
+    std::unordered_map<FileKey, size_t, FileKeyHash> by_file_;
+};
+
+} // namespace soloader
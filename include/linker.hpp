@@ -5,18 +5,36 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <utility>
 #include <unordered_map>
 #include <mutex>
+#include <sys/stat.h>
 
 namespace soloader {
 
 struct TlsIndex;
+struct SharedDependency;
+class LoadContext;
 
 struct LoadedDep {
-    std::unique_ptr<ElfImage> image;
+    std::shared_ptr<ElfImage> image;
     bool is_manual_load = false;
     void* map_base = nullptr;
     size_t map_size = 0;
+    void* handle = nullptr;    // 系统已加载库的 dlopen(RTLD_NOLOAD) 句柄
+    dev_t dev = 0;             // 手动加载时的文件身份
+    ino_t ino = 0;
+    bool root = false;         // 与主库同批或之后显式加入作用域的库（命名空间）
+    SharedDependency* shared = nullptr;    // 进程级共享的副本，映射和析构由注册表负责
+};
+
+// 重定位时绑定到导入符号的槽位（用于运行时重绑定）
+struct ImportSlot {
+    const char* name;       // 指向镜像的 .dynstr
+    ElfImage* image;        // 槽位所在镜像
+    ElfImage* provider;     // 绑定时提供定义的镜像，系统库为 nullptr
+    ElfAddr* target;
+    ElfAddr addend;         // ABS64 的加数，GOT/PLT 槽位为 0
 };
 
 struct SymbolLookup {
@@ -35,6 +53,14 @@ struct SymbolCacheEntry {
     bool found = false;
 };
 
+// 可执行段中被重定位写入过的区间（用于按需刷新指令缓存）
+struct TextWriteRange {
+    uintptr_t start = 0;
+    uintptr_t end = 0;
+    uintptr_t dirty_lo = UINTPTR_MAX;
+    uintptr_t dirty_hi = 0;
+};
+
 class Linker {
 public:
     Linker() = default;
@@ -47,7 +73,13 @@ public:
     Linker& operator=(Linker&&) = delete;
     
     bool init(std::unique_ptr<ElfImage> image);
-    bool link();
+    // roots 为与主库一同加入作用域的已映射库（命名空间），整批加载依赖、注册和重定位
+    bool link(std::vector<LoadedDep> roots = {});
+    // 主库是命名空间中第一个显式加载的库（在 link() 之前设置）：构造先于其他显式加载的库，析构晚于它们
+    void setMainIsRoot(bool enabled) { main_is_root_ = enabled; }
+    // 向已链接的作用域追加一批已映射的库（如同 RTLD_GLOBAL）：新库及其新依赖排在作用域末尾，
+    // 可以解析到之前加载的库；之前的库已完成的绑定不变。依赖加载失败时整批撤销
+    bool addLibraries(std::vector<LoadedDep> libs);
     void destroy();
     void abandon();
     
@@ -58,6 +90,43 @@ public:
     // 获取加载的依赖数量
     size_t dependencyCount() const { return deps_.size(); }
     
+    // 在完整作用域（主库、依赖、系统库）中解析符号，结果进入符号缓存。可与 reloadDependency 并发
+    void* resolveSymbol(std::string_view name) {
+        std::lock_guard<std::mutex> lock(scope_mutex_);
+        return findSymbolCached(name).address;
+    }
+    
+    // 本链接器专用的符号替换（如 arena 分配函数），优先于进程级替换表；在 link() 之前设置
+    void setSymbolOverrides(const std::vector<std::pair<std::string_view, void*>>& overrides);
+    // link() 可能因系统库与替换表冲突而放弃全部替换，调用方据此判断替换是否生效
+    bool hasSymbolOverrides() const { return !overrides_.empty(); }
+    
+    // 把 image（nullptr 表示所有镜像）中绑定到 name 的 GLOB_DAT/JUMP_SLOT/ABS64 槽位改指向 address，
+    // 返回改写的槽位数。代价与该符号的槽位数成正比，只对不可写的页临时修改保护。
+    // 不影响符号缓存和 getSymbol 的结果
+    size_t rebindImport(std::string_view name, void* address, const ElfImage* image = nullptr);
+    
+    // 原地重新加载一个手动加载的依赖（完整路径或文件名）：映射并链接新版本，
+    // 只改写其他镜像中指向旧版本的槽位，然后析构并卸载旧版本。
+    // 新版本缺少被引用的符号或需要作用域中没有的库、其他镜像对它有 TLS 重定位或依赖与其他链接器共享时返回 false。调用方需保证期间没有线程在旧版本中执行
+    bool reloadDependency(std::string_view name);
+    
+    // 分两步的 reloadDependency：发布新版本并改写绑定后把旧版本交给 retired，不析构也不卸载；
+    // 调用方确认并发查找（resolveSymbol 的调用方）已离开旧版本后调用 retireDependency(retired)
+    bool reloadDependency(std::string_view name, LoadedDep& retired);
+    void retireDependency(LoadedDep& retired);
+    
+    // 手动加载的依赖是否通过进程级注册表与其他链接器共享（默认开启），在 link() 之前设置。
+    // 设置了专用符号替换的链接器总是使用私有副本
+    void setShareDependencies(bool enabled) { share_deps_ = enabled; }
+    
+    // 推迟构造函数（在 link() 之前设置）：link/addLibraries 完成重定位后不执行构造函数，
+    // 由 runConstructors() 按原顺序补做。可在工作线程中并行链接，再在一个线程中按确定顺序初始化。
+    // 构造函数执行前销毁的链接器不调用其镜像的析构函数
+    void setDeferConstructors(bool enabled) { defer_constructors_ = enabled; }
+    bool constructorsPending() const { return constructors_pending_; }
+    void runConstructors();
+    
     // 清除符号缓存
     void clearSymbolCache() { 
         std::lock_guard<std::mutex> lock(cache_mutex_);
@@ -65,35 +134,94 @@ public:
     }
 
     static void* loadLibraryManually(std::string_view path, LoadedDep& dep);
+    static void* loadLibraryManually(LoadContext& ctx, LoadedDep& dep);
 
 private:
-    bool loadDependencies();
+    bool loadDependencies(const std::vector<ElfImage*>& roots);
+    void linkImages(size_t first_dep, bool with_main);
+    void construct(size_t first_dep, bool with_main);
+    void discardDependencies(size_t first_dep);
+    void relocateImage(ElfImage* image);
     void processRelocations(ElfImage* image);
     void processRelocation(ElfImage* image, uint32_t sym_idx, uint32_t type,
                           ElfAddr offset, ElfAddr addend, ElfAddr load_bias,
                           ElfSym* dynsym, const char* dynstr, bool is_rela);
     
     SymbolLookup findSymbol(std::string_view name);
+    SymbolLookup findImageSymbol(std::string_view name, uint32_t hash);
+    void* findOverride(std::string_view name, uint32_t hash) const;
+    void dropUnsafeOverrides();
+    
+    struct SlotWrite {
+        ElfImage* image;
+        ElfAddr* target;
+        ElfAddr value;
+    };
+    bool writeSlots(std::vector<SlotWrite>& writes);
+    void buildScopeFilter();
+    void* findSystemSymbol(std::string_view name);
+    void preresolveImports(size_t first_dep, bool with_main);
+    void releaseSystemHandles();
     bool findLibraryPath(std::string_view name, std::string& out);
-    bool isLoaded(std::string_view path);
+    bool isLoaded(std::string_view path, const struct stat* st = nullptr);
     void restoreProtections(ElfImage* image);
+    void beginTextTracking(ElfImage* image);
+    void noteTextWrite(uintptr_t addr, size_t size);
+    void endTextTracking(ElfImage* image);
     void callConstructors(ElfImage* image);
     void callDestructors(ElfImage* image);
+    void constructShared(SharedDependency* dep);
+    void publishSharedDependencies();
+    void releaseSharedDependencies(size_t first_dep = 0);
     
     // 符号缓存查找
     SymbolLookup findSymbolCached(std::string_view name);
     
     std::unique_ptr<ElfImage> main_image_;
     std::vector<LoadedDep> deps_;
+    std::vector<void*> system_scope_;     // 系统库句柄（DT_NEEDED 顺序）
+    
+    struct SymbolOverride {
+        std::string name;
+        uint32_t hash;
+        void* address;
+    };
+    std::vector<SymbolOverride> overrides_;
+    
+    // 作用域过滤器：以 gnuHash 低位索引，每项为可能定义该哈希的镜像位图。
+    // 位 i 对应 scope_images_[i]（主库在前，依赖按加载顺序），按位序遍历即保持插入优先级
+    std::vector<ElfImage*> scope_images_;
+    std::vector<uint64_t> scope_filter_;        // 槽位数 × scope_words_
+    std::vector<uint64_t> scope_unfiltered_;    // 无法枚举符号的镜像，总是搜索
+    size_t scope_words_ = 0;
     size_t main_map_size_ = 0;
     bool is_linked_ = false;
+    bool share_deps_ = true;
+    bool main_is_root_ = false;
+    bool defer_constructors_ = false;
+    bool constructors_pending_ = false;     // 自 pending_dep_ 起的依赖（及 pending_main_ 时主库）尚未构造
+    bool pending_main_ = false;
+    size_t pending_dep_ = 0;
     
     // 符号缓存
     mutable std::mutex cache_mutex_;
     std::unordered_map<std::string, SymbolCacheEntry> symbol_cache_;
 
-    // TLSDESC 分配的 TlsIndex 指针（需要在 destroy 时释放）
-    std::vector<TlsIndex*> tls_indices_;
+    // 全部导入槽位（按重定位顺序），以及首次重绑定时建立的名字索引
+    std::vector<ImportSlot> import_slots_;
+    std::unordered_map<std::string_view, std::vector<uint32_t>> import_index_;
+    std::mutex rebind_mutex_;
+    std::mutex scope_mutex_;        // 串行化 resolveSymbol 与 reloadDependency 对作用域的改写
+
+    // 当前正在重定位镜像的可执行段，以及各镜像被写入的代码区间
+    std::vector<TextWriteRange> text_ranges_;
+    std::unordered_map<ElfImage*, std::vector<TextWriteRange>> text_writes_;
+
+    // TLSDESC 分配的 TlsIndex 指针及其重定位所在镜像（需要在 destroy 时释放）
+    std::vector<std::pair<ElfImage*, TlsIndex*>> tls_indices_;
+
+    // TLS 重定位引用的其他镜像（镜像, 定义方），决定依赖能否共享
+    std::vector<std::pair<ElfImage*, ElfImage*>> tls_providers_;
 };
 
 // 全局参数
@@ -0,0 +1,63 @@
+// Modern C++17 SO Loader - Load Context (arm64 only)
+#pragma once
+
+#include "elf_image.hpp"
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+
+namespace soloader {
+
+// 单个库的加载上下文：只打开一次（O_CLOEXEC）、只 fstat 一次，
+// 同一个 fd 和文件镜像供头部解析、段映射和 ElfImage 构建共用
+class LoadContext {
+public:
+    LoadContext() = default;
+    ~LoadContext();
+
+    LoadContext(const LoadContext&) = delete;
+    LoadContext& operator=(const LoadContext&) = delete;
+    LoadContext(LoadContext&& other) noexcept;
+    LoadContext& operator=(LoadContext&& other) noexcept;
+
+    // 打开并 fstat，仅接受普通文件
+    bool open(std::string_view path);
+
+    // 接管已打开的 fd 和其 stat 结果（批量 I/O 使用），校验规则与 open 相同
+    bool adoptFd(std::string_view path, int fd, const struct stat& st);
+
+    // 接管外部读取好的整文件镜像（malloc 分配）
+    void setImage(void* image);
+
+    // 提示内核异步预读整个文件（POSIX_FADV_WILLNEED），不阻塞
+    void adviseWillNeed() const;
+
+    // 将整个文件读入内存（已读取则直接返回）
+    bool readImage();
+
+    // 关闭 fd 并释放未转移的文件镜像
+    void close();
+
+    // 转移文件镜像所有权（malloc 分配，接收方负责 free）
+    void* releaseImage();
+
+    bool isOpen() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+    const std::string& path() const { return path_; }
+    const struct stat& fileStat() const { return st_; }
+    size_t fileSize() const { return static_cast<size_t>(st_.st_size); }
+
+    // 文件镜像中的 ELF 头和程序头（需先 readImage）
+    const ElfEhdr* header() const { return static_cast<const ElfEhdr*>(image_); }
+    const ElfPhdr* programHeaders() const;
+
+private:
+    bool checkFile();
+
+    std::string path_;
+    int fd_ = -1;
+    struct stat st_{};
+    void* image_ = nullptr;
+};
+
+} // namespace soloader
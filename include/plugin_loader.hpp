@@ -0,0 +1,66 @@
+// Modern C++17 SO Loader - Parallel Plugin Loader (arm64 only)
+#pragma once
+
+#include "soloader.hpp"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace soloader {
+
+struct PluginLoadOptions {
+    size_t threads = 0;                 // 工作线程数（含调用线程），0 为 CPU 数；不超过库数
+    bool share_dependencies = true;     // 见 SoLoader::setShareDependencies
+    bool arena = false;                 // 见 SoLoader::setArenaEnabled（受 kMaxArenas 限制）
+};
+
+// 单个库的加载结果
+struct PluginResult {
+    std::string path;
+    std::unique_ptr<SoLoader> loader;           // 加载失败时为空
+    std::chrono::microseconds load_time{0};     // 工作线程中的映射、解析、依赖加载和重定位
+    std::chrono::microseconds init_time{0};     // 构造函数
+    bool ok() const { return loader != nullptr; }
+};
+
+// 批量加载插件：每个库一个 SoLoader，映射、解析、依赖加载和重定位在工作线程池中并行，
+// 构造函数全部推迟到最后，在调用线程中按输入顺序（目录按文件名排序）执行，初始化顺序确定。
+// 公共依赖经进程级注册表共享，但同时链接同一依赖的工作线程各自持有私有副本
+class PluginLoader {
+public:
+    PluginLoader() = default;
+    ~PluginLoader();
+
+    PluginLoader(const PluginLoader&) = delete;
+    PluginLoader& operator=(const PluginLoader&) = delete;
+
+    // 目录中的 *.so 文件（完整路径，按文件名排序）
+    static std::vector<std::string> listDirectory(std::string_view dir);
+
+    // 加载一批库，结果按输入顺序追加到 results()，返回本批成功数。
+    // 单个库失败不影响其余库；已加载的路径跳过，之前失败的结果在下一批开始时移除，可重新加载
+    size_t load(const std::vector<std::string>& paths, const PluginLoadOptions& options = {});
+    size_t loadDirectory(std::string_view dir, const PluginLoadOptions& options = {}) {
+        return load(listDirectory(dir), options);
+    }
+
+    const std::vector<PluginResult>& results() const { return results_; }
+
+    // 按完整路径或文件名查找已加载的库，未找到返回 nullptr
+    SoLoader* find(std::string_view name) const;
+
+    // 最近一批的总耗时（并行链接与顺序构造之和）
+    std::chrono::microseconds lastBatchTime() const { return last_batch_time_; }
+
+    // 按加载逆序卸载全部库
+    void unloadAll();
+
+private:
+    std::vector<PluginResult> results_;
+    std::chrono::microseconds last_batch_time_{0};
+};
+
+} // namespace soloader
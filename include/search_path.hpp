@@ -0,0 +1,57 @@
+// Modern C++17 SO Loader - Library Search Path (arm64 only)
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_set>
+#include <mutex>
+#include <ctime>
+
+namespace soloader {
+
+// 库搜索路径解析：每个目录只枚举一次到内存哈希集合，按目录 mtime 失效，
+// 查找本身不产生系统调用。无法枚举的目录（如 SELinux 禁止读取）回退到 access() 探测
+class LibrarySearchPath {
+public:
+    static LibrarySearchPath& instance();
+
+    // 替换基础搜索目录（按优先级），默认为 Android 系统库目录，非 Android 为主机 Linux 目录
+    void setSearchPaths(const std::vector<std::string>& dirs);
+
+    // LD_LIBRARY_PATH 风格的冒号分隔目录列表，优先于基础目录；默认取自环境变量 LD_LIBRARY_PATH
+    void setLibraryPath(std::string_view colon_list);
+
+    // 当前生效的目录列表（覆盖目录在前）
+    std::vector<std::string> searchPaths() const;
+
+    // 校验各目录 mtime，变化的目录重新枚举（每次链接开始时调用一次）
+    void refresh();
+
+    // 按优先级查找库名；绝对路径直接检查存在性
+    bool find(std::string_view name, std::string& out);
+
+    // 库路径是否就是 name（完整路径），或文件名部分等于 name
+    static bool matches(std::string_view path, std::string_view name);
+
+private:
+    LibrarySearchPath();
+
+    struct Directory {
+        std::string path;           // 以 '/' 结尾
+        bool scanned = false;
+        bool listable = false;      // 枚举失败时查找回退到 access()
+        struct timespec mtime{};
+        std::unordered_set<std::string> entries;
+    };
+
+    void rebuildLocked();
+    void scanLocked(Directory& dir);
+
+    mutable std::mutex mutex_;
+    std::vector<std::string> base_paths_;
+    std::vector<std::string> override_paths_;
+    std::vector<Directory> dirs_;
+};
+
+} // namespace soloader
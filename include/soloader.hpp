@@ -3,10 +3,48 @@
 
 #include "elf_image.hpp"
 #include "linker.hpp"
+#include "symbol_cache.hpp"
+#include "export_index.hpp"
+#include "arena.hpp"
+#include "epoch.hpp"
 #include <string_view>
+#include <vector>
+#include <cstddef>
+#include <type_traits>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
 
 namespace soloader {
 
+// getSymbol 的查找范围
+enum class SymbolScope {
+    Image,      // 仅主库导出（默认）
+    Global,     // 链接器完整作用域：主库、依赖、系统库
+};
+
+// 函数表绑定项：符号名、成员偏移和编译期计算的 gnuHash
+struct SymbolBinding {
+    std::string_view name;
+    size_t offset;
+    uint32_t hash;
+    bool required;
+};
+
+// 在 constexpr 绑定表中声明成员与符号的对应关系
+#define SOLOADER_BIND(Table, member, symbol) \
+    ::soloader::SymbolBinding{symbol, offsetof(Table, member), ::soloader::gnuHash(symbol), true}
+#define SOLOADER_BIND_OPTIONAL(Table, member, symbol) \
+    ::soloader::SymbolBinding{symbol, offsetof(Table, member), ::soloader::gnuHash(symbol), false}
+
+// 主库导出符号数达到该值时自动构建完美哈希导出表
+inline constexpr size_t kDefaultExportIndexThreshold = 1024;
+
+// reload() 发布新版本后，旧版本在查找全部退出后再保留一段宽限期才析构，
+// 供调用方结束对旧版本函数指针的调用
+inline constexpr std::chrono::milliseconds kDefaultReloadGrace{500};
+
 class SoLoader {
 public:
     SoLoader() = default;
@@ -21,30 +59,149 @@ public:
     // 加载库
     bool load(std::string_view lib_path);
     
-    // 卸载库
+    // 热重载：旧版本继续提供服务，新版本在调用线程中完成加载、链接和构造后原子发布，
+    // 之后 getSymbol 返回新版本的符号。旧版本进入待回收列表，宽限期过后由之后的
+    // load/reload/unload、collectRetired() 或析构函数析构卸载，本调用不等待宽限期。
+    // 新版本加载失败时旧版本保持不变。未加载时等同于 load()
+    bool reload(std::string_view lib_path, std::chrono::milliseconds grace = kDefaultReloadGrace);
+    
+    // 析构卸载宽限期已过的旧版本，返回仍在宽限期内的版本数
+    size_t collectRetired();
+    
+    // 卸载库：先撤下，等待进行中的 getSymbol/bindSymbols 退出后再析构和解除映射。
+    // 已返回的函数指针不受保护，调用方需保证卸载时不再调用
     bool unload();
     
     // 放弃（不调用析构函数）
     bool abandon();
     
-    // 获取符号地址
-    void* getSymbol(std::string_view name);
+    // 获取符号地址（结果按范围缓存，重复查找无锁；可与 unload/reload 并发调用）
+    void* getSymbol(std::string_view name, SymbolScope scope = SymbolScope::Image);
     
     template<typename T>
-    T getSymbol(std::string_view name) {
-        return reinterpret_cast<T>(getSymbol(name));
+    T getSymbol(std::string_view name, SymbolScope scope = SymbolScope::Image) {
+        return reinterpret_cast<T>(getSymbol(name, scope));
+    }
+    
+    // 一次遍历填充整张函数指针表（成员必须是指针大小）。
+    // 缺失的必需符号统一记录到 missing 并返回 false；可选符号缺失时成员置空
+    template<typename Table, size_t N>
+    bool bindSymbols(Table& table, const SymbolBinding (&bindings)[N],
+                     std::vector<std::string_view>* missing = nullptr,
+                     SymbolScope scope = SymbolScope::Image) {
+        static_assert(std::is_standard_layout_v<Table>, "binding table must be standard layout");
+        return bindSymbols(&table, sizeof(Table), bindings, N, missing, scope);
+    }
+    
+    bool bindSymbols(void* table, size_t table_size, const SymbolBinding* bindings, size_t count,
+                     std::vector<std::string_view>* missing = nullptr,
+                     SymbolScope scope = SymbolScope::Image);
+    
+    // 主库导出符号数不少于 count 时在加载时构建完美哈希导出表（SIZE_MAX 关闭）
+    void setExportIndexThreshold(size_t count) { export_index_threshold_ = count; }
+    
+    // 主库的完美哈希导出表（未启用时为 nullptr），可读取构建耗时和内存占用。
+    // 指针属于当前版本，unload/reload 后失效
+    const ExportIndex* exportIndex() const {
+        EpochDomain::Guard guard;
+        auto* gen = current();
+        return gen ? gen->image->exportIndex() : nullptr;
+    }
+    
+    // 主库导出符号枚举（范围和名字指向当前版本的镜像，unload/reload 后失效；
+    // 需要与之并发时改用 forEachExport）
+    ExportRange exports() const {
+        EpochDomain::Guard guard;
+        auto* gen = current();
+        return gen ? gen->image->exports() : ExportRange();
+    }
+    ExportRange exportsWithPrefix(std::string_view prefix) const {
+        EpochDomain::Guard guard;
+        auto* gen = current();
+        return gen ? gen->image->exportsWithPrefix(prefix) : ExportRange();
+    }
+    
+    // 对名字匹配 glob 模式的主库导出调用 fn(name, address)，返回匹配数
+    template<typename Fn>
+    size_t forEachExport(std::string_view pattern, Fn&& fn) const {
+        EpochDomain::Guard guard;
+        auto* gen = current();
+        if (!gen) return 0;
+        auto* image = gen->image;
+        return image->forEachExport(pattern, [&](const ExportedSymbol& sym) {
+            fn(sym.name, reinterpret_cast<void*>(image->symbolAddress(*sym.sym)));
+        });
+    }
+    
+    // 运行时把库（主库及手动加载的依赖）对 name 的全部导入改指向 address，返回改写的槽位数。
+    // 可在追踪实现与快速实现之间切换而无需重新加载；getSymbol 的结果不受影响
+    size_t rebindImport(std::string_view name, void* address) {
+        EpochDomain::Guard guard;
+        auto* gen = current();
+        return gen ? gen->linker.rebindImport(name, address) : 0;
+    }
+    
+    // 原地重新加载一个手动加载的依赖（完整路径或文件名），只改写指向它的绑定，主库不重新链接。
+    // 可与 getSymbol 并发：旧版本在进行中的查找全部退出后才析构和卸载
+    bool reloadDependency(std::string_view name);
+    
+    // 在 load() 之前开启：库的 malloc/free/operator new/delete 等导入绑定到本实例专用的 arena，
+    // unload() 时整体释放。同时开启的实例数受 kMaxArenas 限制，超出时回退到系统分配器
+    void setArenaEnabled(bool enabled) { arena_enabled_ = enabled; }
+    
+    // 在 load() 之前设置：手动加载的依赖是否与其他 SoLoader 共享同一份已链接的副本（默认开启）。
+    // 关闭后依赖的全局状态和构造函数对本实例私有
+    void setShareDependencies(bool enabled) { share_deps_ = enabled; }
+    
+    // 在 load() 之前开启：load() 完成映射、链接和重定位后即返回，构造函数留给 runConstructors()。
+    // 其间可以查找符号，但不应调用库中的函数。reload() 总是在发布前执行构造函数
+    void setDeferConstructors(bool enabled) { defer_constructors_ = enabled; }
+    
+    // 执行 load() 推迟的构造函数（依赖在前，主库最后），未加载返回 false
+    bool runConstructors();
+    
+    // 当前库的 arena（未开启时为 nullptr），可读取分配统计；unload/reload 后失效
+    PluginArena* arena() const {
+        EpochDomain::Guard guard;
+        auto* gen = current();
+        return gen ? gen->arena.get() : nullptr;
     }
     
     // 是否已加载
-    bool isLoaded() const { return image_ != nullptr; }
+    bool isLoaded() const { return current() != nullptr; }
     
-    // 获取库路径
-    const std::string& path() const { return lib_path_; }
+    // 获取库路径（返回副本：reload/unload 会释放当前版本）
+    std::string path() const;
 
 private:
-    std::string lib_path_;
-    ElfImage* image_ = nullptr;
-    Linker linker_;
+    // 一个已加载的版本：链接器、主库镜像及其符号缓存。reload 期间新旧两代并存
+    struct Generation {
+        std::string path;
+        ElfImage* image = nullptr;
+        Linker linker;
+        SymbolCache symbol_caches[2];       // 按 SymbolScope 索引
+        std::unique_ptr<PluginArena> arena;
+    };
+    
+    // reload 撤下、等待宽限期结束的旧版本
+    struct RetiredGeneration {
+        std::chrono::steady_clock::time_point deadline;
+        std::unique_ptr<Generation> gen;
+    };
+    
+    Generation* current() const { return current_.load(std::memory_order_acquire); }
+    std::unique_ptr<Generation> loadGeneration(std::string_view lib_path);
+    void destroyGeneration(std::unique_ptr<Generation> gen);
+    void* lookupSymbol(Generation& gen, std::string_view name, uint32_t hash, SymbolScope scope);
+    
+    std::atomic<Generation*> current_{nullptr};   // 拥有所有权，发布/撤下时原子交换，读者受纪元保护
+    std::mutex lifecycle_mutex_;                    // 串行化 load/reload/unload/abandon
+    std::mutex retire_mutex_;                       // 保护 retired_，回收在 lifecycle_mutex_ 之外进行
+    std::vector<RetiredGeneration> retired_;
+    size_t export_index_threshold_ = kDefaultExportIndexThreshold;
+    bool arena_enabled_ = false;
+    bool share_deps_ = true;
+    bool defer_constructors_ = false;
 };
 
 } // namespace soloader
@@ -0,0 +1,61 @@
+// Modern C++17 SO Loader - Concurrent Symbol Cache (arm64 only)
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace soloader {
+
+// 读无锁的符号地址缓存：开放寻址表，槽位为原子指针，条目发布后不再修改。
+// 写入由互斥锁串行化，扩容时发布新表，旧表和条目保留到 clear() 才释放。
+// 查找只需一次哈希（gnuHash）加少量探测，命中路径无锁、无分配
+class SymbolCache {
+public:
+    SymbolCache();
+    ~SymbolCache();
+
+    SymbolCache(const SymbolCache&) = delete;
+    SymbolCache& operator=(const SymbolCache&) = delete;
+
+    // 命中返回 true，address 为 nullptr 表示已确认符号不存在
+    bool find(std::string_view name, uint32_t hash, void** address) const;
+
+    // 插入结果；名字已存在时忽略。未找到（nullptr）的条目有上限，超出后不再缓存，
+    // 避免探测大量不存在的名字使缓存无限增长
+    void insert(std::string_view name, uint32_t hash, void* address);
+
+    // 撤下全部条目重新开始缓存；旧表和条目保留到 clear()，并发读者仍可安全访问
+    void invalidate();
+
+    // 释放全部条目（调用方需保证没有并发读者）
+    void clear();
+
+private:
+    struct Entry {
+        uint32_t hash;
+        void* address;
+        std::string name;
+    };
+
+    struct Table {
+        explicit Table(size_t capacity);
+        size_t mask;
+        std::unique_ptr<std::atomic<Entry*>[]> slots;
+    };
+
+    static void place(Table* table, Entry* entry);
+
+    std::atomic<Table*> table_{nullptr};
+    std::mutex write_mutex_;
+    std::vector<std::unique_ptr<Table>> tables_;    // 当前表与已退役的表
+    std::vector<std::unique_ptr<Entry>> entries_;
+    std::vector<std::unique_ptr<Entry>> retired_;   // invalidate() 撤下的条目
+    size_t misses_ = 0;                             // entries_ 中未找到的条目数
+};
+
+} // namespace soloader
@@ -0,0 +1,47 @@
+// Modern C++17 SO Loader - System Symbol Cache (arm64 only)
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace soloader {
+
+// 进程级系统符号缓存，所有 Linker 共享：按 dlopen 句柄分别缓存 dlsym 结果
+// （包括未找到），第一级为 RTLD_DEFAULT（与系统链接器一样全局组优先，保留 LD_PRELOAD 与
+// libsigchain 的覆盖），其后为各依赖句柄（RTLD_LOCAL 加载的库）。导入集合相近的插件重复加载时不再调用 dlsym。
+// 进程链接表变化（LinkMap::generation）时整体失效
+class SystemSymbolCache {
+public:
+    static SystemSymbolCache& instance();
+
+    // 链接表代数变化时清空缓存
+    void sync(uint64_t generation);
+
+    // 依次在 RTLD_DEFAULT 及 scope 中各句柄中查找，未找到返回 nullptr
+    void* resolve(const std::vector<void*>& scope, std::string_view name);
+
+    // 批量解析：每级作用域只加锁两次，未命中的名字在锁外调用 dlsym
+    void resolveBatch(const std::vector<void*>& scope,
+                      const std::vector<std::string_view>& names,
+                      std::vector<void*>& out);
+
+    void clear();
+
+private:
+    SystemSymbolCache() = default;
+
+    struct Entry {
+        void* address = nullptr;    // nullptr 表示已确认未找到
+    };
+    using Table = std::unordered_map<std::string, Entry>;
+
+    std::mutex mutex_;
+    uint64_t generation_ = 0;
+    std::unordered_map<void*, Table> tables_;     // 键为句柄，RTLD_DEFAULT 单独一张表
+};
+
+} // namespace soloader
@@ -3,6 +3,7 @@
 
 #include "elf_image.hpp"
 #include <cstddef>
+#include <mutex>
 
 namespace soloader {
 
@@ -23,6 +24,8 @@ struct TlsIndex {
     unsigned long offset;
 };
 
+// 模块注册、注销和线程 TLS 块的分配互斥（可在多个线程中并行链接）；
+// getAddress 不加锁：模块号在注销前不变
 class TlsManager {
 public:
     static TlsManager& instance();
@@ -33,13 +36,17 @@ public:
     void* getAddress(TlsIndex* ti);
     TlsIndex* allocateIndex(ElfImage* image, ElfSym* sym, ElfAddr addend);
     
-    void bumpGeneration() { generation_++; }
+    void bumpGeneration() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation_++;
+    }
 
 private:
     TlsManager();
     void* allocateBlock();
     void* getBlockForThread();
     
+    std::mutex mutex_;
     TlsModule modules_[MAX_TLS_MODULES]{};
     size_t generation_ = 0;
     size_t static_size_ = 0;
@@ -0,0 +1,479 @@
+// Modern C++17 SO Loader - Per-Library Arena Allocator Implementation (arm64 only)
+
+#include "arena.hpp"
+#include "log.hpp"
+#include <sys/mman.h>
+#include <malloc.h>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace soloader {
+
+// 小块规格（16 字节对齐）
+static constexpr uint16_t kClassSizes[] = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256, 320, 384, 448, 512,
+    640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+};
+
+// (size + 15) / 16 → 规格下标
+static constexpr auto kClassForSize = [] {
+    std::array<uint8_t, 2048 / 16 + 1> table{};
+    size_t cls = 0;
+    for (size_t i = 0; i < table.size(); i++) {
+        while (kClassSizes[cls] < i * 16) cls++;
+        table[i] = static_cast<uint8_t>(cls);
+    }
+    return table;
+}();
+
+// 每次从中心链表批量取/还的块数，以及线程缓存每个规格的上限
+static constexpr size_t kRefillBatch = 32;
+static constexpr size_t kCacheLimit = 64;
+// 线程本地计数每累计这么多次操作汇总一次，快速路径上没有原子操作
+static constexpr uint32_t kStatsBatch = 64;
+
+static std::atomic<PluginArena*> g_arenas[kMaxArenas];
+// 串行化线程退出时的缓存归还与 arena 销毁，保证归还期间 arena 不会被释放
+static std::mutex g_slots_mutex;
+static std::atomic<uint64_t> g_next_epoch{0};
+
+// 每个槽位一组独立的分配函数：绑定到库的导入时不携带上下文，只能靠槽位区分 arena
+template<size_t Slot>
+struct ArenaShims {
+    static PluginArena* arena() { return g_arenas[Slot].load(std::memory_order_acquire); }
+
+    static void* shimMalloc(size_t size) {
+        auto* a = arena();
+        return a ? a->allocate(size) : malloc(size);
+    }
+    static void* shimCalloc(size_t count, size_t size) {
+        auto* a = arena();
+        return a ? a->allocateZeroed(count, size) : calloc(count, size);
+    }
+    static void* shimRealloc(void* ptr, size_t size) {
+        auto* a = arena();
+        return a ? a->reallocate(ptr, size) : realloc(ptr, size);
+    }
+    static void shimFree(void* ptr) {
+        if (auto* a = arena()) {
+            a->deallocate(ptr);
+        } else {
+            free(ptr);
+        }
+    }
+    static size_t shimUsableSize(const void* ptr) {
+        auto* a = arena();
+        return a ? a->usableSize(ptr) : malloc_usable_size(const_cast<void*>(ptr));
+    }
+
+    static void* shimNew(size_t size) {
+        void* ptr = shimMalloc(size ? size : 1);
+        if (!ptr) throw std::bad_alloc();
+        return ptr;
+    }
+    static void* shimNewNothrow(size_t size, const std::nothrow_t&) noexcept {
+        return shimMalloc(size ? size : 1);
+    }
+    static void shimDelete(void* ptr) noexcept { shimFree(ptr); }
+    static void shimDeleteSized(void* ptr, size_t) noexcept { shimFree(ptr); }
+    static void shimDeleteNothrow(void* ptr, const std::nothrow_t&) noexcept { shimFree(ptr); }
+
+    static std::vector<std::pair<std::string_view, void*>> table() {
+        return {
+            {"malloc", reinterpret_cast<void*>(&shimMalloc)},
+            {"calloc", reinterpret_cast<void*>(&shimCalloc)},
+            {"realloc", reinterpret_cast<void*>(&shimRealloc)},
+            {"free", reinterpret_cast<void*>(&shimFree)},
+            {"malloc_usable_size", reinterpret_cast<void*>(&shimUsableSize)},
+            {"_Znwm", reinterpret_cast<void*>(&shimNew)},
+            {"_Znam", reinterpret_cast<void*>(&shimNew)},
+            {"_ZnwmRKSt9nothrow_t", reinterpret_cast<void*>(&shimNewNothrow)},
+            {"_ZnamRKSt9nothrow_t", reinterpret_cast<void*>(&shimNewNothrow)},
+            {"_ZdlPv", reinterpret_cast<void*>(&shimDelete)},
+            {"_ZdaPv", reinterpret_cast<void*>(&shimDelete)},
+            {"_ZdlPvm", reinterpret_cast<void*>(&shimDeleteSized)},
+            {"_ZdaPvm", reinterpret_cast<void*>(&shimDeleteSized)},
+            {"_ZdlPvRKSt9nothrow_t", reinterpret_cast<void*>(&shimDeleteNothrow)},
+            {"_ZdaPvRKSt9nothrow_t", reinterpret_cast<void*>(&shimDeleteNothrow)},
+        };
+    }
+};
+
+template<size_t... Slots>
+static auto makeShimTables(std::index_sequence<Slots...>) {
+    return std::array<std::vector<std::pair<std::string_view, void*>>, kMaxArenas>{
+        ArenaShims<Slots>::table()...};
+}
+
+struct PluginArena::ThreadCache {
+    uint64_t epoch;
+    FreeBlock* head[kSizeClasses];
+    size_t count[kSizeClasses];
+    // 尚未汇总到 arena 的小块计数
+    size_t allocations;
+    size_t frees;
+    size_t bytes_allocated;
+    size_t bytes_freed;
+    uint32_t ops;
+};
+
+// 线程退出时把各槽位缓存的空闲块与未汇总的计数还给仍存活的 arena，
+// 否则这些块在库卸载前无法被其他线程复用
+struct PluginArena::ThreadCaches {
+    ThreadCache caches[kMaxArenas];
+
+    ~ThreadCaches() {
+        std::lock_guard<std::mutex> lock(g_slots_mutex);
+        for (size_t slot = 0; slot < kMaxArenas; slot++) {
+            auto* arena = g_arenas[slot].load(std::memory_order_acquire);
+            if (arena && caches[slot].epoch == arena->epoch_) {
+                arena->releaseThreadCache(caches[slot]);
+            }
+        }
+    }
+};
+
+static size_t chunkSlot(uintptr_t base, size_t slots) {
+    return static_cast<size_t>(((base >> 20) * 0x9e3779b97f4a7c15ULL) >> 32) & (slots - 1);
+}
+
+std::unique_ptr<PluginArena> PluginArena::create() {
+    uint64_t epoch = g_next_epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+    std::unique_ptr<PluginArena> arena(new PluginArena(epoch));
+
+    for (size_t slot = 0; slot < kMaxArenas; slot++) {
+        PluginArena* expected = nullptr;
+        if (g_arenas[slot].compare_exchange_strong(expected, arena.get(), std::memory_order_acq_rel)) {
+            arena->slot_ = slot;
+            return arena;
+        }
+    }
+
+    LOGE("All %zu arena slots are in use", kMaxArenas);
+    return nullptr;
+}
+
+PluginArena::PluginArena(uint64_t epoch)
+    : epoch_(epoch), chunks_(new ChunkEntry[kChunkSlots]) {}
+
+PluginArena::~PluginArena() {
+    // create() 未能占用槽位的 arena 没有分配过内存
+    std::unique_lock<std::mutex> slots_lock(g_slots_mutex);
+    if (g_arenas[slot_].load(std::memory_order_acquire) == this) {
+        [[maybe_unused]] auto st = stats();
+        LOGI("Arena %zu: %zu allocations, %zu frees, %zu bytes in use, peak %zu, reserved %zu",
+             slot_, st.allocations, st.frees, st.bytes_in_use, st.peak_bytes, st.reserved_bytes);
+        g_arenas[slot_].store(nullptr, std::memory_order_release);
+    }
+    slots_lock.unlock();
+
+    for (size_t i = 0; i < kChunkSlots; i++) {
+        if (uintptr_t base = chunks_[i].base.load(std::memory_order_relaxed)) {
+            munmap(reinterpret_cast<void*>(base), kChunkSize);
+        }
+    }
+    for (auto& [ptr, size] : large_) {
+        free(ptr);
+    }
+}
+
+const std::vector<std::pair<std::string_view, void*>>& PluginArena::overrides() const {
+    static const auto tables = makeShimTables(std::make_index_sequence<kMaxArenas>{});
+    return tables[slot_];
+}
+
+ArenaStats PluginArena::stats() {
+    flushStats(threadCache());
+    
+    ArenaStats st;
+    st.allocations = allocations_.load(std::memory_order_relaxed);
+    st.frees = frees_.load(std::memory_order_relaxed);
+    st.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+    st.peak_bytes = peak_bytes_.load(std::memory_order_relaxed);
+    st.reserved_bytes = reserved_bytes_.load(std::memory_order_relaxed);
+    st.large_allocations = large_allocations_.load(std::memory_order_relaxed);
+    return st;
+}
+
+PluginArena::ThreadCache& PluginArena::threadCache() {
+    static thread_local ThreadCaches thread_caches;
+    auto& tc = thread_caches.caches[slot_];
+    if (tc.epoch != epoch_) {
+        // 槽位已换成新的 arena，旧链表指向的内存已随旧 arena 释放
+        memset(&tc, 0, sizeof(tc));
+        tc.epoch = epoch_;
+    }
+    return tc;
+}
+
+void PluginArena::noteAlloc(size_t bytes) {
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    size_t now = bytes_in_use_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = peak_bytes_.load(std::memory_order_relaxed);
+    while (now > peak && !peak_bytes_.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+    }
+}
+
+void PluginArena::noteFree(size_t bytes) {
+    frees_.fetch_add(1, std::memory_order_relaxed);
+    bytes_in_use_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void PluginArena::flushStats(ThreadCache& tc) {
+    if (!tc.ops) return;
+
+    allocations_.fetch_add(tc.allocations, std::memory_order_relaxed);
+    frees_.fetch_add(tc.frees, std::memory_order_relaxed);
+    // 峰值按批次采样
+    size_t now = bytes_in_use_.fetch_add(tc.bytes_allocated - tc.bytes_freed, std::memory_order_relaxed) +
+                 tc.bytes_allocated - tc.bytes_freed;
+    size_t peak = peak_bytes_.load(std::memory_order_relaxed);
+    while (now > peak && !peak_bytes_.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+    }
+
+    tc.allocations = tc.frees = tc.bytes_allocated = tc.bytes_freed = 0;
+    tc.ops = 0;
+}
+
+void PluginArena::releaseThreadCache(ThreadCache& tc) {
+    flushStats(tc);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t cls = 0; cls < kSizeClasses; cls++) {
+        FreeBlock* first = tc.head[cls];
+        if (!first) continue;
+        FreeBlock* last = first;
+        while (last->next) last = last->next;
+        last->next = free_lists_[cls];
+        free_lists_[cls] = first;
+    }
+    // 之后同一线程的 TLS 析构若再分配，按新缓存重新开始
+    memset(&tc, 0, sizeof(tc));
+}
+
+const PluginArena::ChunkEntry* PluginArena::findChunk(const void* ptr) const {
+    uintptr_t base = reinterpret_cast<uintptr_t>(ptr) & ~(kChunkSize - 1);
+    for (size_t i = chunkSlot(base, kChunkSlots);; i = (i + 1) & (kChunkSlots - 1)) {
+        uintptr_t entry = chunks_[i].base.load(std::memory_order_acquire);
+        if (entry == base) return &chunks_[i];
+        if (entry == 0) return nullptr;
+    }
+}
+
+bool PluginArena::newChunkLocked() {
+    if (chunk_count_ >= kChunkSlots / 2) return false;
+
+    // 多映射一个 chunk 再裁剪，得到按 kChunkSize 对齐的区域，指针可直接推出所属 chunk
+    void* raw = mmap(nullptr, kChunkSize * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        PLOGE("mmap arena chunk");
+        return false;
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t base = (start + kChunkSize - 1) & ~(kChunkSize - 1);
+    if (base > start) munmap(raw, base - start);
+    if (base + kChunkSize < start + kChunkSize * 2)
+        munmap(reinterpret_cast<void*>(base + kChunkSize), start + kChunkSize * 2 - base - kChunkSize);
+
+    size_t i = chunkSlot(base, kChunkSlots);
+    while (chunks_[i].base.load(std::memory_order_relaxed)) i = (i + 1) & (kChunkSlots - 1);
+    chunks_[i].base.store(base, std::memory_order_release);
+
+    current_chunk_ = &chunks_[i];
+    next_page_ = 0;
+    chunk_count_++;
+    reserved_bytes_.fetch_add(kChunkSize, std::memory_order_relaxed);
+    return true;
+}
+
+bool PluginArena::newPageLocked(size_t cls) {
+    if (next_page_ == kPagesPerChunk && !newChunkLocked()) return false;
+
+    uintptr_t page = current_chunk_->base.load(std::memory_order_relaxed) + next_page_ * kPageSize;
+    current_chunk_->page_class[next_page_++] = static_cast<uint8_t>(cls);
+    page_cursor_[cls] = page;
+    page_end_[cls] = page + kPageSize;
+    return true;
+}
+
+PluginArena::FreeBlock* PluginArena::refillLocked(size_t cls, size_t* count) {
+    FreeBlock* head = nullptr;
+    size_t n = 0;
+
+    while (n < kRefillBatch && free_lists_[cls]) {
+        FreeBlock* block = free_lists_[cls];
+        free_lists_[cls] = block->next;
+        block->next = head;
+        head = block;
+        n++;
+    }
+
+    size_t size = kClassSizes[cls];
+    while (n < kRefillBatch) {
+        if (page_cursor_[cls] + size > page_end_[cls] && !newPageLocked(cls)) break;
+        auto* block = reinterpret_cast<FreeBlock*>(page_cursor_[cls]);
+        page_cursor_[cls] += size;
+        block->next = head;
+        head = block;
+        n++;
+    }
+
+    *count = n;
+    return head;
+}
+
+void* PluginArena::allocateLarge(size_t size) {
+    void* ptr = malloc(size);
+    if (!ptr) return nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        large_[ptr] = size;
+    }
+    large_count_.fetch_add(1, std::memory_order_release);
+    large_allocations_.fetch_add(1, std::memory_order_relaxed);
+    reserved_bytes_.fetch_add(size, std::memory_order_relaxed);
+    noteAlloc(size);
+    return ptr;
+}
+
+void* PluginArena::allocate(size_t size) {
+    if (size > kMaxSmallSize) return allocateLarge(size);
+
+    size_t cls = kClassForSize[(size + 15) / 16];
+    auto& tc = threadCache();
+    FreeBlock* block = tc.head[cls];
+    if (!block) {
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            block = refillLocked(cls, &count);
+        }
+        // chunk 数达到上限时退回系统分配器
+        if (!block) return allocateLarge(size);
+        tc.count[cls] = count;
+    }
+
+    tc.head[cls] = block->next;
+    tc.count[cls]--;
+    tc.allocations++;
+    tc.bytes_allocated += kClassSizes[cls];
+    if (++tc.ops >= kStatsBatch) flushStats(tc);
+    return block;
+}
+
+void* PluginArena::allocateZeroed(size_t count, size_t size) {
+    size_t total;
+    if (__builtin_mul_overflow(count, size, &total)) return nullptr;
+    void* ptr = allocate(total);
+    if (ptr) memset(ptr, 0, total);
+    return ptr;
+}
+
+void PluginArena::deallocate(void* ptr) {
+    if (!ptr) return;
+
+    auto* chunk = findChunk(ptr);
+    if (!chunk) {
+        deallocateForeign(ptr);
+        return;
+    }
+
+    uintptr_t offset = reinterpret_cast<uintptr_t>(ptr) - chunk->base.load(std::memory_order_relaxed);
+    size_t cls = chunk->page_class[offset / kPageSize];
+
+    auto& tc = threadCache();
+    tc.frees++;
+    tc.bytes_freed += kClassSizes[cls];
+    if (++tc.ops >= kStatsBatch) flushStats(tc);
+
+    auto* block = static_cast<FreeBlock*>(ptr);
+    block->next = tc.head[cls];
+    tc.head[cls] = block;
+    if (++tc.count[cls] <= kCacheLimit) return;
+
+    // 线程缓存过长，归还一批到中心链表供其他线程使用
+    FreeBlock* first = tc.head[cls];
+    FreeBlock* last = first;
+    for (size_t i = 1; i < kRefillBatch; i++) last = last->next;
+    tc.head[cls] = last->next;
+    tc.count[cls] -= kRefillBatch;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    last->next = free_lists_[cls];
+    free_lists_[cls] = first;
+}
+
+void PluginArena::deallocateForeign(void* ptr) {
+    if (large_count_.load(std::memory_order_acquire)) {
+        size_t size = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = large_.find(ptr);
+            if (it != large_.end()) {
+                size = it->second;
+                large_.erase(it);
+            }
+        }
+        if (size) {
+            large_count_.fetch_sub(1, std::memory_order_relaxed);
+            reserved_bytes_.fetch_sub(size, std::memory_order_relaxed);
+            noteFree(size);
+        }
+    }
+    // 大块分配，或库从系统分配器得到的指针（如 strdup 的结果）
+    free(ptr);
+}
+
+void* PluginArena::reallocate(void* ptr, size_t size) {
+    if (!ptr) return allocate(size);
+    if (size == 0) {
+        deallocate(ptr);
+        return nullptr;
+    }
+
+    if (findChunk(ptr)) {
+        size_t old_size = usableSize(ptr);
+        if (size <= old_size) return ptr;
+        void* out = allocate(size);
+        if (!out) return nullptr;
+        memcpy(out, ptr, old_size);
+        deallocate(ptr);
+        return out;
+    }
+
+    if (large_count_.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = large_.find(ptr);
+        if (it != large_.end()) {
+            size_t old_size = it->second;
+            void* out = realloc(ptr, size);
+            if (!out) return nullptr;
+            large_.erase(it);
+            large_[out] = size;
+            // 无符号回绕即为差值
+            reserved_bytes_.fetch_add(size - old_size, std::memory_order_relaxed);
+            bytes_in_use_.fetch_add(size - old_size, std::memory_order_relaxed);
+            return out;
+        }
+    }
+    return realloc(ptr, size);
+}
+
+size_t PluginArena::usableSize(const void* ptr) const {
+    if (!ptr) return 0;
+    if (auto* chunk = findChunk(ptr)) {
+        uintptr_t offset = reinterpret_cast<uintptr_t>(ptr) - chunk->base.load(std::memory_order_relaxed);
+        return kClassSizes[chunk->page_class[offset / kPageSize]];
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = large_.find(const_cast<void*>(ptr));
+        if (it != large_.end()) return it->second;
+    }
+    return malloc_usable_size(const_cast<void*>(ptr));
+}
+
+} // namespace soloader
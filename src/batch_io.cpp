@@ -0,0 +1,429 @@
+// Modern C++17 SO Loader - Batched I/O Implementation (arm64 only)
+
+#include "batch_io.hpp"
+#include "log.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#if defined(SOLOADER_IO_URING) && defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define SOLOADER_HAVE_IO_URING 1
+#endif
+#endif
+
+namespace soloader {
+
+#ifdef SOLOADER_HAVE_IO_URING
+
+// 最小 io_uring 封装（不依赖 liburing）：每批提交后等待全部完成
+class IoRing {
+public:
+    ~IoRing() {
+        if (sqes_) munmap(sqes_, sqes_len_);
+        if (cq_ptr_ && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_len_);
+        if (sq_ptr_) munmap(sq_ptr_, sq_len_);
+        if (fd_ >= 0) close(fd_);
+    }
+
+    bool init(unsigned entries) {
+        io_uring_params p{};
+        fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+        if (fd_ < 0) {
+            PLOGE("io_uring_setup");
+            return false;
+        }
+
+        sq_len_ = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+        cq_len_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap && cq_len_ > sq_len_) sq_len_ = cq_len_;
+
+        sq_ptr_ = mmap(nullptr, sq_len_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if (sq_ptr_ == MAP_FAILED) {
+            sq_ptr_ = nullptr;
+            PLOGE("mmap io_uring sq");
+            return false;
+        }
+
+        if (single_mmap) {
+            cq_ptr_ = sq_ptr_;
+        } else {
+            cq_ptr_ = mmap(nullptr, cq_len_, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+            if (cq_ptr_ == MAP_FAILED) {
+                cq_ptr_ = nullptr;
+                PLOGE("mmap io_uring cq");
+                return false;
+            }
+        }
+
+        sqes_len_ = p.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqes_len_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            PLOGE("mmap io_uring sqes");
+            return false;
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        auto* sq = static_cast<uint8_t*>(sq_ptr_);
+        sq_tail_ = reinterpret_cast<uint32_t*>(sq + p.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<uint32_t*>(sq + p.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<uint32_t*>(sq + p.sq_off.array);
+        sq_entries_ = p.sq_entries;
+
+        auto* cq = static_cast<uint8_t*>(cq_ptr_);
+        cq_head_ = reinterpret_cast<uint32_t*>(cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<uint32_t*>(cq + p.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<uint32_t*>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+        return supportsOps();
+    }
+
+    unsigned capacity() const { return sq_entries_; }
+
+    io_uring_sqe* next(uint64_t user_data) {
+        uint32_t tail = *sq_tail_;
+        uint32_t idx = tail & sq_mask_;
+        auto* sqe = &sqes_[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->user_data = user_data;
+        sq_array_[idx] = idx;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        pending_++;
+        return sqe;
+    }
+
+    // 提交所有已准备的 SQE 并等待全部完成。失败时已提交的请求可能已交给 io-wq、
+    // 仍会写入调用方的缓冲区：返回前等待它们全部完成，等待不成功时 quiesced() 为 false
+    template<typename OnComplete>
+    bool submitAndWait(OnComplete&& on_complete) {
+        unsigned to_submit = pending_;
+        unsigned inflight = pending_;
+        pending_ = 0;
+
+        while (inflight > 0) {
+            long ret = syscall(__NR_io_uring_enter, fd_, to_submit, 1,
+                               IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret < 0) {
+                if (errno == EINTR) continue;
+                PLOGE("io_uring_enter");
+                drain(inflight - to_submit, on_complete);
+                return false;
+            }
+            to_submit -= std::min<unsigned>(to_submit, static_cast<unsigned>(ret));
+            inflight -= reap(on_complete);
+        }
+        return true;
+    }
+
+    // 没有仍可能写入调用方内存的请求（submitAndWait 失败后为 false 时缓冲区不能释放）
+    bool quiesced() const { return quiesced_; }
+
+private:
+    template<typename OnComplete>
+    unsigned reap(OnComplete&& on_complete) {
+        uint32_t head = *cq_head_;
+        uint32_t tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+        for (; head != tail; head++, count++) {
+            auto* cqe = &cqes_[head & cq_mask_];
+            on_complete(cqe->user_data, cqe->res);
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    // 只等待完成、不再提交（未被内核取走的 SQE 随 ring 销毁丢弃）
+    template<typename OnComplete>
+    void drain(unsigned submitted, OnComplete&& on_complete) {
+        while (submitted > 0) {
+            long ret = syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret < 0 && errno != EINTR) {
+                PLOGE("io_uring_enter (drain)");
+                quiesced_ = false;
+                return;
+            }
+            submitted -= std::min(submitted, reap(on_complete));
+        }
+    }
+
+    bool supportsOps() {
+        constexpr size_t kMaxOps = 256;
+        size_t probe_size = sizeof(io_uring_probe) + kMaxOps * sizeof(io_uring_probe_op);
+        auto* probe = static_cast<io_uring_probe*>(calloc(1, probe_size));
+        if (!probe) return false;
+
+        bool ok = syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe, kMaxOps) == 0;
+        for (int op : {IORING_OP_STATX, IORING_OP_OPENAT, IORING_OP_READ}) {
+            if (!ok) break;
+            ok = op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+        }
+        free(probe);
+
+        if (!ok) LOGW("io_uring lacks STATX/OPENAT/READ support");
+        return ok;
+    }
+
+    int fd_ = -1;
+    void* sq_ptr_ = nullptr;
+    void* cq_ptr_ = nullptr;
+    size_t sq_len_ = 0;
+    size_t cq_len_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_len_ = 0;
+
+    uint32_t* sq_tail_ = nullptr;
+    uint32_t* sq_array_ = nullptr;
+    uint32_t sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+
+    uint32_t* cq_head_ = nullptr;
+    uint32_t* cq_tail_ = nullptr;
+    uint32_t cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    unsigned pending_ = 0;
+    bool quiesced_ = true;
+};
+
+// 按队列容量分块提交：prep(i, sqe) 准备第 i 项，done(i, res) 处理结果
+template<typename Prep, typename Done>
+static bool runBatch(IoRing& ring, size_t count, Prep&& prep, Done&& done) {
+    for (size_t first = 0; first < count; first += ring.capacity()) {
+        size_t last = std::min(count, first + ring.capacity());
+        for (size_t i = first; i < last; i++) {
+            prep(i, ring.next(i));
+        }
+        if (!ring.submitAndWait(done)) return false;
+    }
+    return true;
+}
+
+static void statxToStat(const struct statx& sx, struct stat& st) {
+    st = {};
+    st.st_dev = makedev(sx.stx_dev_major, sx.stx_dev_minor);
+    st.st_ino = sx.stx_ino;
+    st.st_mode = sx.stx_mode;
+    st.st_nlink = sx.stx_nlink;
+    st.st_uid = sx.stx_uid;
+    st.st_gid = sx.stx_gid;
+    st.st_size = static_cast<off_t>(sx.stx_size);
+    st.st_mtim.tv_sec = sx.stx_mtime.tv_sec;
+    st.st_mtim.tv_nsec = sx.stx_mtime.tv_nsec;
+}
+
+#else
+
+class IoRing {};
+
+#endif // SOLOADER_HAVE_IO_URING
+
+BatchIo& BatchIo::instance() {
+    static BatchIo inst;
+    return inst;
+}
+
+BatchIo::BatchIo() {
+    // Android 应用进程的 seccomp/SELinux 策略通常禁止 io_uring，默认同步实现
+#if defined(SOLOADER_HAVE_IO_URING) && !defined(__ANDROID__)
+    setBackend(Backend::IoUring);
+#endif
+}
+
+BatchIo::~BatchIo() = default;
+
+bool BatchIo::setBackend(Backend backend) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (backend == Backend::Sync) {
+        ring_.reset();
+        return true;
+    }
+
+#ifdef SOLOADER_HAVE_IO_URING
+    if (ring_) return true;
+    auto ring = std::make_unique<IoRing>();
+    if (!ring->init(64)) {
+        LOGW("io_uring unavailable, using synchronous I/O");
+        return false;
+    }
+    ring_ = std::move(ring);
+    LOGD("Batched I/O backend: io_uring");
+    return true;
+#else
+    LOGW("io_uring backend not compiled in");
+    return false;
+#endif
+}
+
+BatchIo::Backend BatchIo::backend() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ring_ ? Backend::IoUring : Backend::Sync;
+}
+
+void BatchIo::openAndRead(const std::vector<std::string>& paths,
+                          std::vector<LoadContext>& contexts) {
+    contexts.clear();
+    contexts.resize(paths.size());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (ring_ && openAndReadUring(paths, contexts)) return;
+    }
+    openAndReadSync(paths, contexts);
+}
+
+void BatchIo::openAndReadSync(const std::vector<std::string>& paths,
+                              std::vector<LoadContext>& contexts) {
+    // 先全部打开并发起预读，读取时前面的拷贝与后面文件的磁盘 I/O 重叠
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (contexts[i].open(paths[i])) contexts[i].adviseWillNeed();
+    }
+    for (auto& ctx : contexts) {
+        if (ctx.isOpen() && !ctx.readImage()) ctx.close();
+    }
+}
+
+#ifdef SOLOADER_HAVE_IO_URING
+
+bool BatchIo::openAndReadUring(const std::vector<std::string>& paths,
+                               std::vector<LoadContext>& contexts) {
+    static const char kEmptyPath[] = "";
+    size_t n = paths.size();
+    std::vector<int> fds(n, -1);
+    std::vector<struct statx> stx(n);
+    std::vector<int> stx_res(n, -1);
+
+    std::vector<void*> buffers(n, nullptr);
+    auto fail = [&]() {
+        // 未能确认全部完成的 STATX/READ 仍可能写入 stx 和读缓冲区，宁可泄漏也不释放
+        if (ring_->quiesced()) {
+            for (void* buf : buffers) free(buf);
+        } else {
+            new std::vector<struct statx>(std::move(stx));
+        }
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+        contexts.clear();
+        contexts.resize(n);
+        ring_.reset();
+        return false;
+    };
+
+    // 1. 批量 openat
+    bool ok = runBatch(*ring_, n,
+        [&](size_t i, io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uintptr_t>(paths[i].c_str());
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        },
+        [&](uint64_t i, int res) {
+            if (res >= 0) {
+                fds[i] = res;
+            } else {
+                LOGE("open %s: %s", paths[i].c_str(), strerror(-res));
+            }
+        });
+    if (!ok) return fail();
+
+    // 2. 基于 fd 的批量 statx（等价于 fstat）
+    std::vector<size_t> opened;
+    for (size_t i = 0; i < n; i++) {
+        if (fds[i] >= 0) opened.push_back(i);
+    }
+    ok = runBatch(*ring_, opened.size(),
+        [&](size_t k, io_uring_sqe* sqe) {
+            size_t i = opened[k];
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = fds[i];
+            sqe->addr = reinterpret_cast<uintptr_t>(kEmptyPath);
+            sqe->len = STATX_BASIC_STATS;
+            sqe->off = reinterpret_cast<uintptr_t>(&stx[i]);
+            sqe->statx_flags = AT_EMPTY_PATH;
+        },
+        [&](uint64_t k, int res) { stx_res[opened[k]] = res; });
+    if (!ok) return fail();
+
+    // 交给上下文校验，fd 所有权随之转移
+    std::vector<size_t> done(n, 0);
+    std::vector<size_t> reading;
+    for (size_t i : opened) {
+        int fd = fds[i];
+        fds[i] = -1;
+        if (stx_res[i] != 0) {
+            LOGE("fstat %s: %s", paths[i].c_str(), strerror(-stx_res[i]));
+            close(fd);
+            continue;
+        }
+
+        struct stat st;
+        statxToStat(stx[i], st);
+        if (!contexts[i].adoptFd(paths[i], fd, st)) continue;
+
+        buffers[i] = malloc(contexts[i].fileSize());
+        if (!buffers[i]) {
+            LOGE("Failed to allocate %zu bytes", contexts[i].fileSize());
+            contexts[i].close();
+            continue;
+        }
+        reading.push_back(i);
+    }
+
+    // 3. 批量读取整个文件，短读时对剩余部分再次提交
+    while (!reading.empty()) {
+        std::vector<size_t> again;
+        ok = runBatch(*ring_, reading.size(),
+            [&](size_t k, io_uring_sqe* sqe) {
+                size_t i = reading[k];
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = contexts[i].fd();
+                sqe->addr = reinterpret_cast<uintptr_t>(buffers[i]) + done[i];
+                sqe->len = static_cast<uint32_t>(
+                    std::min<size_t>(contexts[i].fileSize() - done[i], 1u << 30));
+                sqe->off = done[i];
+            },
+            [&](uint64_t k, int res) {
+                size_t i = reading[k];
+                if (res <= 0) {
+                    LOGE("read %s: %s", paths[i].c_str(), res ? strerror(-res) : "EOF");
+                    free(buffers[i]);
+                    buffers[i] = nullptr;
+                    contexts[i].close();
+                    return;
+                }
+                done[i] += res;
+                if (done[i] < contexts[i].fileSize()) {
+                    again.push_back(i);
+                } else {
+                    contexts[i].setImage(buffers[i]);
+                    buffers[i] = nullptr;
+                }
+            });
+        if (!ok) return fail();
+        reading.swap(again);
+    }
+
+    return true;
+}
+
+#else
+
+bool BatchIo::openAndReadUring(const std::vector<std::string>&, std::vector<LoadContext>&) {
+    return false;
+}
+
+#endif // SOLOADER_HAVE_IO_URING
+
+} // namespace soloader
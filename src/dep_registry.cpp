@@ -0,0 +1,91 @@
+// Modern C++17 SO Loader - Shared Dependency Registry Implementation (arm64 only)
+
+#include "dep_registry.hpp"
+#include "log.hpp"
+#include <algorithm>
+
+namespace soloader {
+
+DependencyRegistry& DependencyRegistry::instance() {
+    static DependencyRegistry inst;
+    return inst;
+}
+
+SharedDependency* DependencyRegistry::acquire(const struct stat& st, std::string_view build_id) {
+    if (build_id.empty()) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find({st.st_dev, st.st_ino});
+    if (it == entries_.end()) return nullptr;
+
+    auto* dep = it->second.get();
+    if (dep->build_id != build_id) {
+        // 同一 inode 被原地改写：已链接的副本与文件内容不一致，调用方加载私有副本
+        LOGW("Build-id of %s changed on disk, not sharing", dep->image->path().c_str());
+        return nullptr;
+    }
+    dep->refs++;
+    return dep;
+}
+
+void DependencyRegistry::publish(std::vector<std::unique_ptr<SharedDependency>>& batch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 已被登记的文件（或同一批中经不同路径重复映射的文件）不能重复登记；
+    // 依赖未登记项的项同样不能共享，反复剔除直到稳定
+    std::vector<SharedDependency*> rejected;
+    std::unordered_map<FileKey, SharedDependency*, FileKeyHash> seen;
+    for (auto& dep : batch) {
+        FileKey key{dep->dev, dep->ino};
+        if (dep->build_id.empty() || entries_.count(key) || !seen.emplace(key, dep.get()).second) {
+            rejected.push_back(dep.get());
+        }
+    }
+    for (bool changed = !rejected.empty(); changed;) {
+        changed = false;
+        for (auto& dep : batch) {
+            if (std::find(rejected.begin(), rejected.end(), dep.get()) != rejected.end()) continue;
+            for (auto* provider : dep->providers) {
+                if (std::find(rejected.begin(), rejected.end(), provider) != rejected.end()) {
+                    rejected.push_back(dep.get());
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (auto& dep : batch) {
+        if (std::find(rejected.begin(), rejected.end(), dep.get()) != rejected.end()) continue;
+        dep->refs++;
+        for (auto* provider : dep->providers) provider->refs++;
+        LOGD("Sharing %s (%zu providers)", dep->image->path().c_str(), dep->providers.size());
+        FileKey key{dep->dev, dep->ino};
+        entries_.emplace(key, std::move(dep));
+    }
+    batch.erase(std::remove(batch.begin(), batch.end(), nullptr), batch.end());
+}
+
+void DependencyRegistry::release(SharedDependency* dep,
+                                 std::vector<std::unique_ptr<SharedDependency>>& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    releaseLocked(dep, out);
+}
+
+void DependencyRegistry::releaseLocked(SharedDependency* dep,
+                                       std::vector<std::unique_ptr<SharedDependency>>& out) {
+    if (--dep->refs > 0) return;
+
+    // 先析构引用方，再释放其 providers
+    auto it = entries_.find({dep->dev, dep->ino});
+    out.push_back(std::move(it->second));
+    entries_.erase(it);
+    for (auto* provider : dep->providers) releaseLocked(provider, out);
+}
+
+size_t DependencyRegistry::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+} // namespace soloader
@@ -1,13 +1,14 @@
 // Modern C++17 SO Loader - ELF Image Implementation (arm64 only)
 
 #include "elf_image.hpp"
+#include "load_context.hpp"
+#include "link_map.hpp"
+#include "export_index.hpp"
 #include "log.hpp"
-#include <fcntl.h>
-#include <unistd.h>
-#include <sys/stat.h>
 #include <sys/mman.h>
 #include <sys/auxv.h>
 #include <cstring>
+#include <algorithm>
 
 namespace soloader {
 
@@ -69,23 +70,47 @@ static bool validateElfHeader(const ElfEhdr* header, size_t file_size) {
     return true;
 }
 
-uint32_t elfHash(std::string_view name) {
-    uint32_t h = 0;
-    for (char c : name) {
-        h = (h << 4) + static_cast<uint8_t>(c);
-        uint32_t g = h & 0xf0000000;
-        if (g) h ^= g >> 24;
-        h &= ~g;
+std::string_view findBuildId(const ElfEhdr* header, size_t file_size) {
+    if (!header || !header->e_phoff ||
+        header->e_phoff + header->e_phnum * sizeof(ElfPhdr) > file_size) {
+        return {};
     }
-    return h;
+    
+    auto* file = reinterpret_cast<const uint8_t*>(header);
+    auto* phdr = reinterpret_cast<const ElfPhdr*>(file + header->e_phoff);
+    for (int i = 0; i < header->e_phnum; i++) {
+        if (phdr[i].p_type != PT_NOTE || phdr[i].p_offset + phdr[i].p_filesz > file_size) continue;
+        
+        // 注释项：namesz、descsz、type，随后为 4 字节对齐的名字和内容
+        size_t pos = phdr[i].p_offset;
+        size_t end = pos + phdr[i].p_filesz;
+        while (pos + sizeof(Elf64_Nhdr) <= end) {
+            auto* note = reinterpret_cast<const Elf64_Nhdr*>(file + pos);
+            size_t name_off = pos + sizeof(Elf64_Nhdr);
+            size_t desc_off = name_off + ((note->n_namesz + 3) & ~size_t(3));
+            size_t next = desc_off + ((note->n_descsz + 3) & ~size_t(3));
+            if (next > end) break;
+            
+            if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 &&
+                memcmp(file + name_off, "GNU", 4) == 0) {
+                return {reinterpret_cast<const char*>(file + desc_off), note->n_descsz};
+            }
+            pos = next;
+        }
+    }
+    return {};
 }
 
-uint32_t gnuHash(std::string_view name) {
-    uint32_t h = 5381;
-    for (char c : name) {
-        h = (h << 5) + h + static_cast<uint8_t>(c);
-    }
-    return h;
+const IfuncArg& ifuncArg() {
+    static const IfuncArg arg{sizeof(IfuncArg), getauxval(AT_HWCAP), getauxval(AT_HWCAP2)};
+    return arg;
+}
+
+ElfAddr callIfuncResolver(uintptr_t resolver) {
+    // arm64 约定：第一个参数为 hwcap | _IFUNC_ARG_HWCAP，第二个参数指向 IfuncArg
+    auto& arg = ifuncArg();
+    using Resolver = ElfAddr(*)(uint64_t, const IfuncArg*);
+    return reinterpret_cast<Resolver>(resolver)(arg.hwcap | (1ULL << 62), &arg);
 }
 
 ElfImage::~ElfImage() {
@@ -143,6 +168,19 @@ ElfImage& ElfImage::operator=(ElfImage&& other) noexcept {
         eh_frame_size_ = other.eh_frame_size_;
         eh_frame_hdr_ = other.eh_frame_hdr_;
         eh_frame_hdr_size_ = other.eh_frame_hdr_size_;
+        export_index_ = std::move(other.export_index_);
+        {
+            std::lock_guard<std::mutex> lock(other.ifunc_mutex_);
+            ifunc_cache_ = std::move(other.ifunc_cache_);
+            other.ifunc_cache_.clear();
+        }
+        {
+            std::lock_guard<std::mutex> lock(other.sorted_exports_mutex_);
+            sorted_exports_ = std::move(other.sorted_exports_);
+            sorted_exports_built_ = other.sorted_exports_built_;
+            other.sorted_exports_.clear();
+            other.sorted_exports_built_ = false;
+        }
         
         // 清空源对象
         other.header_ = nullptr;
@@ -160,69 +198,70 @@ std::unique_ptr<ElfImage> ElfImage::create(std::string_view path, void* base) {
     return img;
 }
 
+std::unique_ptr<ElfImage> ElfImage::create(LoadContext& ctx, void* base) {
+    auto img = std::unique_ptr<ElfImage>(new ElfImage());
+    if (!img->init(ctx, base)) {
+        return nullptr;
+    }
+    return img;
+}
+
+std::unique_ptr<ElfImage> ElfImage::parseFile(std::string_view path) {
+    auto img = std::unique_ptr<ElfImage>(new ElfImage());
+    img->path_ = path;
+    
+    LoadContext ctx;
+    if (!ctx.open(path) || !img->adoptImage(ctx)) {
+        return nullptr;
+    }
+    return img;
+}
+
 bool ElfImage::init(std::string_view path, void* base) {
     path_ = path;
     
+    // 先确定基址，系统未加载的库无需打开文件
+    if (!locateBase(base, nullptr)) return false;
+    
+    LoadContext ctx;
+    if (!ctx.open(path_)) return false;
+    return adoptImage(ctx);
+}
+
+bool ElfImage::init(LoadContext& ctx, void* base) {
+    path_ = ctx.path();
+    
+    if (!locateBase(base, &ctx.fileStat())) return false;
+    return adoptImage(ctx);
+}
+
+bool ElfImage::locateBase(void* base, const struct stat* st) {
     if (base) {
         base_ = base;
         LOGD("Using provided base %p for %s", base, path_.c_str());
-    } else {
-        // 尝试通过 dl_iterate_phdr 查找
-        dl_iterate_phdr([](dl_phdr_info* info, size_t, void* data) -> int {
-            auto* self = static_cast<ElfImage*>(data);
-            if (info->dlpi_name && strstr(info->dlpi_name, self->path_.c_str())) {
-                self->base_ = reinterpret_cast<void*>(info->dlpi_addr);
-                self->path_ = info->dlpi_name;
-                return 1;
-            }
-            return 0;
-        }, this);
-        
-        if (!base_) {
-            LOGE("Failed to find base for %s", path_.c_str());
-            return false;
-        }
-    }
-    
-    // 打开并读取文件
-    int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
-    if (fd < 0) {
-        PLOGE("open %s", path_.c_str());
-        return false;
-    }
-    
-    struct stat st;
-    if (fstat(fd, &st) != 0) {
-        PLOGE("fstat %s", path_.c_str());
-        close(fd);
-        return false;
+        return true;
     }
     
-    file_size_ = st.st_size;
-    if (file_size_ <= sizeof(ElfEhdr)) {
-        LOGE("File too small: %s", path_.c_str());
-        close(fd);
-        return false;
+    // 在进程链接表快照中精确查找：路径 → 文件身份 → soname（仅裸库名）
+    auto& link_map = LinkMap::instance();
+    link_map.refresh();
+    base_ = link_map.findBase(path_, st);
+    if (!base_ && path_.find('/') == std::string::npos) {
+        base_ = link_map.findSoname(path_, &path_);
     }
     
-    header_ = static_cast<ElfEhdr*>(malloc(file_size_));
-    if (!header_) {
-        LOGE("Failed to allocate %zu bytes", file_size_);
-        close(fd);
+    if (!base_) {
+        LOGE("Failed to find base for %s", path_.c_str());
         return false;
     }
+    return true;
+}
+
+bool ElfImage::adoptImage(LoadContext& ctx) {
+    if (!ctx.readImage()) return false;
     
-    size_t total = 0;
-    while (total < file_size_) {
-        ssize_t n = read(fd, reinterpret_cast<char*>(header_) + total, file_size_ - total);
-        if (n <= 0) {
-            PLOGE("read %s", path_.c_str());
-            close(fd);
-            return false;
-        }
-        total += n;
-    }
-    close(fd);
+    file_size_ = ctx.fileSize();
+    header_ = static_cast<ElfEhdr*>(ctx.releaseImage());
     
     // 完整验证 ELF 头
     if (!validateElfHeader(header_, file_size_)) {
@@ -338,6 +377,9 @@ bool ElfImage::parseDynamic() {
         }
     }
 
+    // 仅解析文件时没有运行时映射，动态段和 eh_frame 地址无从计算
+    if (!base_) return true;
+
     // 第二遍：使用正确的 bias 处理其他段
     ElfDyn* dyn = nullptr;
     for (int i = 0; i < header_->e_phnum; i++) {
@@ -481,37 +523,131 @@ std::optional<ElfAddr> ElfImage::linearLookup(std::string_view name, uint8_t* ty
 }
 
 std::optional<ElfAddr> ElfImage::findSymbolOffset(std::string_view name, uint8_t* type, uint8_t* bind) const {
-    if (auto addr = gnuHashLookup(name, gnuHash(name), type, bind)) return addr;
+    return findSymbolOffset(name, gnuHash(name), type, bind);
+}
+
+std::optional<ElfAddr> ElfImage::findSymbolOffset(std::string_view name, uint32_t gnu_hash,
+                                                  uint8_t* type, uint8_t* bind) const {
+    if (export_index_) {
+        // 完美哈希覆盖全部导出符号：命中只需一次探测和一次比较。未命中时跳过 GNU/ELF 哈希，
+        // 但仍线性扫描 .symtab（非导出的函数/对象），与未建索引时的查找结果一致
+        if (uint32_t idx = export_index_->find(name, gnu_hash)) {
+            auto* sym = dynsym_start_ + idx;
+            if (type) *type = elf_st_type(sym->st_info);
+            if (bind) *bind = elf_st_bind(sym->st_info);
+            return sym->st_value;
+        }
+        return linearLookup(name, type, bind);
+    }
+    
+    if (auto addr = gnuHashLookup(name, gnu_hash, type, bind)) return addr;
     if (auto addr = elfHashLookup(name, elfHash(name), type, bind)) return addr;
     if (auto addr = linearLookup(name, type, bind)) return addr;
     return std::nullopt;
 }
 
 std::optional<ElfAddr> ElfImage::findSymbolAddress(std::string_view name, uint8_t* bind) const {
+    return findSymbolAddress(name, gnuHash(name), bind);
+}
+
+std::optional<ElfAddr> ElfImage::findSymbolAddress(std::string_view name, uint32_t gnu_hash,
+                                                   uint8_t* bind) const {
     uint8_t sym_type = 0;
-    auto offset = findSymbolOffset(name, &sym_type, bind);
+    auto offset = findSymbolOffset(name, gnu_hash, &sym_type, bind);
     if (!offset || !base_) return std::nullopt;
     
     auto addr = reinterpret_cast<uintptr_t>(base_) + *offset - bias_;
     
     // 处理 IFUNC
     if (sym_type == STT_GNU_IFUNC) {
-        LOGD("Resolving IFUNC: %.*s", static_cast<int>(name.size()), name.data());
+        return resolveIfunc(addr);
+    }
+    
+    return addr;
+}
+
+ElfAddr ElfImage::symbolAddress(const ElfSym& sym) const {
+    if (!base_) return 0;
+    auto addr = reinterpret_cast<uintptr_t>(base_) + sym.st_value - bias_;
+    if (elf_st_type(sym.st_info) == STT_GNU_IFUNC) {
+        return resolveIfunc(addr);
+    }
+    return addr;
+}
+
+size_t ElfImage::dynsymCount() const {
+    if (!dynsym_start_ || !dynsym_shdr_ || !strtab_start_ || dynsym_shdr_->sh_entsize != sizeof(ElfSym))
+        return 0;
+    return dynsym_shdr_->sh_size / sizeof(ElfSym);
+}
+
+ExportRange ElfImage::exports() const {
+    return ExportRange(dynsym_start_, strtab_start_, nullptr, 1, std::max<size_t>(dynsymCount(), 1));
+}
+
+ExportRange ElfImage::exportsWithPrefix(std::string_view prefix) const {
+    std::lock_guard<std::mutex> lock(sorted_exports_mutex_);
+    if (!sorted_exports_built_) {
+        size_t count = dynsymCount();
+        for (size_t i = 1; i < count; i++) {
+            if (isExportedSymbol(dynsym_start_[i])) sorted_exports_.push_back(static_cast<uint32_t>(i));
+        }
         
-        // arm64 IFUNC 解析
-        struct IfuncArg {
-            unsigned long size;
-            unsigned long hwcap;
-            unsigned long hwcap2;
+        // 按名字排序，同名（多版本）符号只保留下标最小的一个
+        auto name_of = [this](uint32_t idx) {
+            return std::string_view(strtab_start_ + dynsym_start_[idx].st_name);
         };
-        
-        IfuncArg arg{sizeof(IfuncArg), getauxval(AT_HWCAP), getauxval(AT_HWCAP2)};
-        using Resolver = ElfAddr(*)(uint64_t, IfuncArg*);
-        
-        return reinterpret_cast<Resolver>(addr)(arg.hwcap | (1ULL << 62), &arg);
+        std::stable_sort(sorted_exports_.begin(), sorted_exports_.end(),
+                         [&](uint32_t a, uint32_t b) { return name_of(a) < name_of(b); });
+        sorted_exports_.erase(std::unique(sorted_exports_.begin(), sorted_exports_.end(),
+                                          [&](uint32_t a, uint32_t b) { return name_of(a) == name_of(b); }),
+                              sorted_exports_.end());
+        sorted_exports_.shrink_to_fit();
+        sorted_exports_built_ = true;
+        LOGD("Sorted %zu exports of %s", sorted_exports_.size(), path_.c_str());
+    }
+    
+    // [第一个 >= prefix 的名字, 第一个不以 prefix 开头的名字)
+    auto first = std::lower_bound(sorted_exports_.begin(), sorted_exports_.end(), prefix,
+                                  [this](uint32_t idx, std::string_view p) {
+                                      return std::string_view(strtab_start_ + dynsym_start_[idx].st_name) < p;
+                                  });
+    auto last = std::partition_point(first, sorted_exports_.end(), [&](uint32_t idx) {
+        return std::string_view(strtab_start_ + dynsym_start_[idx].st_name).substr(0, prefix.size()) == prefix;
+    });
+    return ExportRange(dynsym_start_, strtab_start_, sorted_exports_.data(),
+                       first - sorted_exports_.begin(), last - sorted_exports_.begin());
+}
+
+bool ElfImage::buildExportIndex(size_t min_exports) {
+    if (export_index_) return true;
+    size_t count = dynsymCount();
+    if (!count) return false;
+    if (ExportIndex::countExports(dynsym_start_, count) < min_exports) return false;
+    
+    export_index_ = ExportIndex::build(dynsym_start_, count, strtab_start_);
+    if (!export_index_) return false;
+    
+    [[maybe_unused]] auto& stats = export_index_->stats();
+    LOGI("Export index for %s: %zu symbols, %zu buckets, %zu bytes, built in %.3f ms",
+         path_.c_str(), stats.symbols, stats.buckets, stats.bytes, stats.build_ms);
+    return true;
+}
+
+ElfAddr ElfImage::resolveIfunc(uintptr_t resolver) const {
+    {
+        std::lock_guard<std::mutex> lock(ifunc_mutex_);
+        auto it = ifunc_cache_.find(resolver);
+        if (it != ifunc_cache_.end()) return it->second;
     }
     
-    return addr;
+    // 解析器在锁外调用，重复解析的结果相同
+    LOGD("Resolving IFUNC at %p in %s", reinterpret_cast<void*>(resolver), path_.c_str());
+    ElfAddr target = callIfuncResolver(resolver);
+    
+    std::lock_guard<std::mutex> lock(ifunc_mutex_);
+    ifunc_cache_.emplace(resolver, target);
+    return target;
 }
 
 SymbolInfo ElfImage::getSymbolAt(uintptr_t addr) const {
@@ -0,0 +1,88 @@
+// Modern C++17 SO Loader - Epoch-Based Reclamation Implementation (arm64 only)
+
+#include "epoch.hpp"
+#include <thread>
+
+namespace soloader {
+
+struct EpochDomain::ThreadState {
+    Record* record = nullptr;
+    unsigned depth = 0;
+
+    ~ThreadState() {
+        if (record) record->in_use.store(false, std::memory_order_release);
+    }
+};
+
+EpochDomain& EpochDomain::instance() {
+    static EpochDomain inst;
+    return inst;
+}
+
+EpochDomain::ThreadState& EpochDomain::threadState() {
+    static thread_local ThreadState state;
+    return state;
+}
+
+EpochDomain::Guard::Guard() {
+    EpochDomain::instance().enter();
+}
+
+EpochDomain::Guard::~Guard() {
+    EpochDomain::instance().leave();
+}
+
+EpochDomain::Record* EpochDomain::acquireRecord() {
+    // 优先复用已退出线程留下的记录
+    for (Record* r = records_.load(std::memory_order_acquire); r; r = r->next) {
+        bool expected = false;
+        if (!r->in_use.load(std::memory_order_relaxed) &&
+            r->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return r;
+        }
+    }
+
+    auto* r = new Record;
+    r->in_use.store(true, std::memory_order_relaxed);
+    Record* head = records_.load(std::memory_order_relaxed);
+    do {
+        r->next = head;
+    } while (!records_.compare_exchange_weak(head, r, std::memory_order_release,
+                                             std::memory_order_relaxed));
+    return r;
+}
+
+void EpochDomain::enter() {
+    auto& state = threadState();
+    if (state.depth++ > 0) return;
+    if (!state.record) state.record = acquireRecord();
+
+    state.record->epoch.store(epoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    // 登记必须先于之后对共享指针的读取可见，与 synchronize() 中的屏障配对
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void EpochDomain::leave() {
+    auto& state = threadState();
+    if (--state.depth > 0) return;
+    state.record->epoch.store(0, std::memory_order_release);
+}
+
+void EpochDomain::synchronize() {
+    // 调用方此前的撤下（原子交换）先于对读者记录的检查
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    std::lock_guard<std::mutex> lock(sync_mutex_);
+    uint64_t target = epoch_.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+    // 登记了旧纪元的读者可能仍持有撤下前读到的指针；登记新纪元的读者必然看到撤下后的状态
+    for (Record* r = records_.load(std::memory_order_acquire); r; r = r->next) {
+        for (;;) {
+            uint64_t e = r->epoch.load(std::memory_order_acquire);
+            if (e == 0 || e >= target) break;
+            std::this_thread::yield();
+        }
+    }
+}
+
+} // namespace soloader
@@ -0,0 +1,163 @@
+// Modern C++17 SO Loader - Perfect-Hash Export Index Implementation (arm64 only)
+
+#include "export_index.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+
+namespace soloader {
+
+// 平均每桶符号数，越大位移表越小、构建越慢
+static constexpr size_t kBucketLoad = 4;
+// 单个桶尝试的位移上限，超过则换种子重建
+static constexpr uint32_t kMaxDisplacements = 1u << 22;
+static constexpr int kMaxSeeds = 8;
+
+// splitmix64 末端混合
+static inline uint64_t mix(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+// 把 32 位哈希映射到 [0, n)，用乘法代替取模
+static inline uint32_t reduce(uint32_t h, uint32_t n) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(h) * n) >> 32);
+}
+
+size_t ExportIndex::countExports(const ElfSym* dynsym, size_t count) {
+    if (!dynsym) return 0;
+    size_t n = 0;
+    for (size_t i = 1; i < count; i++) {
+        if (isExportedSymbol(dynsym[i])) n++;
+    }
+    return n;
+}
+
+std::unique_ptr<ExportIndex> ExportIndex::build(const ElfSym* dynsym, size_t count,
+                                                const char* strtab) {
+    if (!dynsym || !strtab) return nullptr;
+    auto start = std::chrono::steady_clock::now();
+
+    auto index = std::unique_ptr<ExportIndex>(new ExportIndex());
+    index->dynsym_ = dynsym;
+    index->strtab_ = strtab;
+
+    // 同名（多版本）符号只保留下标最小的一个，与 GNU hash 链的查找顺序一致。
+    // 哈希完全相同的符号无法被完美哈希区分，除第一个外放入溢出表
+    struct Key {
+        uint32_t index;
+        uint32_t hash;
+    };
+    std::vector<Key> keys;
+    std::unordered_set<std::string_view> seen_names;
+    std::unordered_set<uint32_t> seen_hashes;
+    for (size_t i = 1; i < count; i++) {
+        if (!isExportedSymbol(dynsym[i])) continue;
+        std::string_view name = strtab + dynsym[i].st_name;
+        if (!seen_names.insert(name).second) continue;
+
+        uint32_t hash = gnuHash(name);
+        if (seen_hashes.insert(hash).second) {
+            keys.push_back({static_cast<uint32_t>(i), hash});
+        } else {
+            index->overflow_.push_back({hash, static_cast<uint32_t>(i)});
+        }
+    }
+    if (keys.empty()) return nullptr;
+
+    const uint32_t n = static_cast<uint32_t>(keys.size());
+    const uint32_t nbuckets = static_cast<uint32_t>((n + kBucketLoad - 1) / kBucketLoad);
+
+    std::vector<uint64_t> hashes(n);
+    std::vector<std::vector<uint32_t>> buckets(nbuckets);
+    std::vector<uint32_t> order(nbuckets), positions;
+    std::vector<uint8_t> taken(n);
+    bool built = false;
+
+    for (int attempt = 0; attempt < kMaxSeeds && !built; attempt++) {
+        index->seed_ = 0x9e3779b97f4a7c15ULL * (attempt + 1);
+
+        // 按桶分组，大桶优先放置
+        for (auto& bucket : buckets) bucket.clear();
+        for (uint32_t k = 0; k < n; k++) {
+            hashes[k] = mix(keys[k].hash ^ index->seed_);
+            buckets[reduce(static_cast<uint32_t>(hashes[k] >> 32), nbuckets)].push_back(k);
+        }
+        for (uint32_t b = 0; b < nbuckets; b++) order[b] = b;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        std::fill(taken.begin(), taken.end(), 0);
+        index->displacement_.assign(nbuckets, 0);
+        index->slots_.assign(n, 0);
+        built = true;
+
+        for (uint32_t b : order) {
+            auto& members = buckets[b];
+            if (members.empty()) break;
+
+            // 依次尝试位移 d，直到桶内所有符号落在互不相同的空槽
+            bool placed = false;
+            for (uint32_t d = 0; d < kMaxDisplacements && !placed; d++) {
+                positions.clear();
+                placed = true;
+                for (uint32_t k : members) {
+                    uint32_t pos = reduce(static_cast<uint32_t>(mix(hashes[k] ^ d)), n);
+                    if (taken[pos] || std::find(positions.begin(), positions.end(), pos) != positions.end()) {
+                        placed = false;
+                        break;
+                    }
+                    positions.push_back(pos);
+                }
+                if (placed) {
+                    index->displacement_[b] = d;
+                    for (size_t j = 0; j < members.size(); j++) {
+                        taken[positions[j]] = 1;
+                        index->slots_[positions[j]] = keys[members[j]].index;
+                    }
+                }
+            }
+            if (!placed) {
+                built = false;
+                break;
+            }
+        }
+    }
+
+    if (!built) {
+        LOGW("Failed to build perfect hash over %u exports", n);
+        return nullptr;
+    }
+
+    index->size_ = n;
+    auto& stats = index->stats_;
+    stats.symbols = n + index->overflow_.size();
+    stats.buckets = nbuckets;
+    stats.bytes = (index->displacement_.size() + index->slots_.size()) * sizeof(uint32_t) +
+                  index->overflow_.size() * sizeof(index->overflow_[0]);
+    stats.build_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    return index;
+}
+
+uint32_t ExportIndex::find(std::string_view name, uint32_t gnu_hash) const {
+    uint64_t h = mix(gnu_hash ^ seed_);
+    uint32_t d = displacement_[reduce(static_cast<uint32_t>(h >> 32),
+                                      static_cast<uint32_t>(displacement_.size()))];
+    uint32_t idx = slots_[reduce(static_cast<uint32_t>(mix(h ^ d)), size_)];
+    if (name == strtab_ + dynsym_[idx].st_name) return idx;
+
+    // 与其他导出符号 gnuHash 完全相同的少数符号
+    for (auto& [hash, overflow_idx] : overflow_) {
+        if (hash == gnu_hash && name == strtab_ + dynsym_[overflow_idx].st_name) return overflow_idx;
+    }
+    return 0;
+}
+
+} // namespace soloader
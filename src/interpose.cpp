@@ -0,0 +1,75 @@
+// Modern C++17 SO Loader - Symbol Interposition Table Implementation (arm64 only)
+
+#include "interpose.hpp"
+#include "elf_image.hpp"
+#include "backtrace.hpp"
+#include "log.hpp"
+
+namespace soloader {
+
+static uint64_t filterBit(uint32_t hash) {
+    return uint64_t(1) << (hash & 63);
+}
+
+InterposeTable& InterposeTable::instance() {
+    static InterposeTable inst;
+    return inst;
+}
+
+InterposeTable::InterposeTable() {
+    add("dl_iterate_phdr", reinterpret_cast<void*>(&BacktraceManager::customDlIteratePhdr));
+    add("dladdr", reinterpret_cast<void*>(&BacktraceManager::customDladdr));
+}
+
+void InterposeTable::add(std::string_view name, void* replacement) {
+    if (!replacement) {
+        remove(name);
+        return;
+    }
+
+    uint32_t hash = gnuHash(name);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto range = entries_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.first == name) {
+            it->second.second = replacement;
+            return;
+        }
+    }
+    entries_.emplace(hash, std::make_pair(std::string(name), replacement));
+    filter_.fetch_or(filterBit(hash), std::memory_order_release);
+    LOGD("Interposing %.*s -> %p", static_cast<int>(name.size()), name.data(), replacement);
+}
+
+bool InterposeTable::remove(std::string_view name) {
+    uint32_t hash = gnuHash(name);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto range = entries_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.first == name) {
+            entries_.erase(it);
+            rebuildFilterLocked();
+            return true;
+        }
+    }
+    return false;
+}
+
+void InterposeTable::rebuildFilterLocked() {
+    uint64_t filter = 0;
+    for (auto& entry : entries_) filter |= filterBit(entry.first);
+    filter_.store(filter, std::memory_order_release);
+}
+
+void* InterposeTable::find(std::string_view name, uint32_t gnu_hash) const {
+    if (!(filter_.load(std::memory_order_acquire) & filterBit(gnu_hash))) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto range = entries_.equal_range(gnu_hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.first == name) return it->second.second;
+    }
+    return nullptr;
+}
+
+} // namespace soloader
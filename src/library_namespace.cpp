@@ -0,0 +1,171 @@
+// Modern C++17 SO Loader - Library Namespace Implementation (arm64 only)
+
+#include "library_namespace.hpp"
+#include "load_context.hpp"
+#include "search_path.hpp"
+#include "epoch.hpp"
+#include "log.hpp"
+#include <sys/mman.h>
+#include <algorithm>
+
+namespace soloader {
+
+// 映射一个库并解析其镜像，dep 记录映射范围和文件身份
+static std::unique_ptr<ElfImage> mapLibrary(const std::string& path, LoadedDep& dep) {
+    LoadContext ctx;
+    if (!ctx.open(path)) {
+        LOGE("Library file not accessible: %s", path.c_str());
+        return nullptr;
+    }
+    
+    void* base = Linker::loadLibraryManually(ctx, dep);
+    if (!base) {
+        LOGE("Failed to map library into memory: %s", path.c_str());
+        return nullptr;
+    }
+    
+    auto image = ElfImage::create(ctx, base);
+    if (!image) {
+        LOGE("Failed to parse ELF image: %s", path.c_str());
+        munmap(base, dep.map_size);
+        return nullptr;
+    }
+    dep.dev = ctx.fileStat().st_dev;
+    dep.ino = ctx.fileStat().st_ino;
+    return image;
+}
+
+LibraryNamespace::~LibraryNamespace() {
+    if (isLoaded()) {
+        unload();
+    }
+}
+
+bool LibraryNamespace::load(const std::vector<std::string>& paths) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    // 映射整批库；失败时解除本批已完成的映射
+    std::vector<LoadedDep> libs;
+    std::vector<std::unique_ptr<ElfImage>> images;
+    auto discard = [&] {
+        for (auto& lib : libs) munmap(lib.map_base, lib.map_size);
+    };
+    for (auto& path : paths) {
+        bool duplicate = std::any_of(libraries_.begin(), libraries_.end(),
+                                     [&](ElfImage* image) { return image->path() == path; }) ||
+                         std::any_of(images.begin(), images.end(),
+                                     [&](const auto& image) { return image->path() == path; });
+        if (duplicate) {
+            LOGW("Already in namespace: %s", path.c_str());
+            continue;
+        }
+        
+        LoadedDep lib;
+        auto image = mapLibrary(path, lib);
+        if (!image) {
+            discard();
+            return false;
+        }
+        libs.push_back(std::move(lib));
+        images.push_back(std::move(image));
+    }
+    if (libs.empty()) return true;
+    
+    std::vector<ElfImage*> added;
+    for (auto& image : images) added.push_back(image.get());
+    
+    if (!linker_.isLinked()) {
+        // 第一批：首个库作为作用域的主库，其余与它一同链接；构造和析构顺序仍按加载顺序
+        size_t main_map_size = libs.front().map_size;
+        if (!linker_.init(std::move(images.front()))) {
+            LOGE("Failed to initialize namespace linker");
+            discard();
+            return false;
+        }
+        linker_.setMainMapSize(main_map_size);
+        linker_.setMainIsRoot(true);
+        
+        std::vector<LoadedDep> roots;
+        for (size_t i = 1; i < libs.size(); i++) {
+            libs[i].image = std::move(images[i]);
+            roots.push_back(std::move(libs[i]));
+        }
+        if (!linker_.link(std::move(roots))) {
+            LOGE("Failed to link %zu libraries", added.size());
+            linker_.destroy();
+            return false;
+        }
+    } else {
+        for (size_t i = 0; i < libs.size(); i++) {
+            libs[i].image = std::move(images[i]);
+        }
+        if (!linker_.addLibraries(std::move(libs))) {
+            LOGE("Failed to add %zu libraries", added.size());
+            return false;
+        }
+    }
+    
+    libraries_.insert(libraries_.end(), added.begin(), added.end());
+    
+    // 之前缓存的"未找到"可能由新库定义；并发读者仍可访问旧表
+    cache_.invalidate();
+    
+    LOGI("Namespace now holds %zu libraries (%zu dependencies)", libraries_.size(),
+         linker_.dependencyCount() - (libraries_.size() - 1));
+    return true;
+}
+
+bool LibraryNamespace::unload() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!linker_.isLinked()) {
+        LOGW("Namespace is empty");
+        return false;
+    }
+    
+    // 撤下缓存并等待无锁命中路径上的读者离开，之后才析构和解除映射
+    cache_.invalidate();
+    EpochDomain::instance().synchronize();
+    
+    linker_.destroy();
+    libraries_.clear();
+    cache_.clear();
+    return true;
+}
+
+void* LibraryNamespace::getSymbol(std::string_view name) {
+    uint32_t hash = gnuHash(name);
+    void* addr = nullptr;
+    {
+        // 读者区只覆盖缓存访问：未命中时要等待 mutex_，而持有它的 unload 会等待读者离开
+        EpochDomain::Guard guard;
+        if (cache_.find(name, hash, &addr)) return addr;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!linker_.isLinked()) return nullptr;
+    addr = linker_.resolveSymbol(name);
+    cache_.insert(name, hash, addr);
+    return addr;
+}
+
+void* LibraryNamespace::getSymbol(std::string_view library, std::string_view name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto* image : libraries_) {
+        if (!LibrarySearchPath::matches(image->path(), library)) continue;
+        auto addr = image->findSymbolAddress(name);
+        return addr ? reinterpret_cast<void*>(*addr) : nullptr;
+    }
+    return nullptr;
+}
+
+size_t LibraryNamespace::libraryCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return libraries_.size();
+}
+
+bool LibraryNamespace::isLoaded() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return linker_.isLinked();
+}
+
+} // namespace soloader
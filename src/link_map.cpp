@@ -0,0 +1,168 @@
+// Modern C++17 SO Loader - Process Link Map Snapshot Implementation (arm64 only)
+
+#include "link_map.hpp"
+#include "log.hpp"
+#include <link.h>
+#include <cstddef>
+
+namespace soloader {
+
+// 从内存中的动态段读取 DT_SONAME。glibc 会把 DT_STRTAB 重定位为绝对地址，
+// bionic 保留原始虚拟地址，小于加载偏移时按相对地址处理
+static std::string readSoname(const dl_phdr_info* info) {
+    for (size_t i = 0; i < info->dlpi_phnum; i++) {
+        auto* phdr = &info->dlpi_phdr[i];
+        if (phdr->p_type != PT_DYNAMIC) continue;
+
+        auto* dyn = reinterpret_cast<const ElfW(Dyn)*>(info->dlpi_addr + phdr->p_vaddr);
+        uintptr_t strtab = 0;
+        size_t soname = SIZE_MAX;
+        for (auto* d = dyn; d->d_tag != DT_NULL; d++) {
+            if (d->d_tag == DT_STRTAB) strtab = d->d_un.d_ptr;
+            else if (d->d_tag == DT_SONAME) soname = d->d_un.d_val;
+        }
+        if (!strtab || soname == SIZE_MAX) return {};
+        if (strtab < info->dlpi_addr) strtab += info->dlpi_addr;
+        return reinterpret_cast<const char*>(strtab + soname);
+    }
+    return {};
+}
+
+LinkMap& LinkMap::instance() {
+    static LinkMap inst;
+    return inst;
+}
+
+void LinkMap::addModule(Module module) {
+    size_t index = modules_.size();
+
+    if (!module.path.empty()) by_path_.emplace(module.path, index);
+    if (!module.soname.empty()) by_soname_.emplace(module.soname, index);
+    if (module.ino) by_file_.emplace(FileKey{module.dev, module.ino}, index);
+
+    modules_.push_back(std::move(module));
+}
+
+bool LinkMap::sameModulesLocked() const {
+    // 模块数与按链表顺序的加载地址都未变时视为未变化；只读取 dl_phdr_info，不 stat、不分配
+    struct Compare {
+        const std::vector<uintptr_t>* bases;
+        size_t index = 0;
+        bool same = true;
+    } cmp{&bases_};
+
+    dl_iterate_phdr([](dl_phdr_info* info, size_t, void* data) -> int {
+        auto* cmp = static_cast<Compare*>(data);
+        if (cmp->index >= cmp->bases->size() || (*cmp->bases)[cmp->index] != info->dlpi_addr) {
+            cmp->same = false;
+            return 1;
+        }
+        cmp->index++;
+        return 0;
+    }, &cmp);
+    return cmp.same && cmp.index == bases_.size();
+}
+
+void LinkMap::refresh() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 没有 dlpi_adds/dlpi_subs 的系统（API 26-29）先比较指纹，未变化时不重建、不递增代数
+    if (snapshot_taken_ && !valid_ && sameModulesLocked()) return;
+
+    struct Scan {
+        LinkMap* self;
+        size_t index = 0;
+        size_t skip = 0;
+        bool started = false;
+        bool unchanged = false;
+    } scan{this};
+
+    dl_iterate_phdr([](dl_phdr_info* info, size_t size, void* data) -> int {
+        auto* scan = static_cast<Scan*>(data);
+        auto* self = scan->self;
+
+        if (!scan->started) {
+            scan->started = true;
+
+            // 旧版 bionic 不提供计数，只能整表重建
+            bool has_counters = size >= offsetof(dl_phdr_info, dlpi_subs) + sizeof(info->dlpi_subs);
+            if (has_counters && self->valid_ && info->dlpi_subs == self->subs_) {
+                if (info->dlpi_adds == self->adds_) {
+                    scan->unchanged = true;
+                    return 1;
+                }
+                // 只有新增：已有模块在链表中的位置不变，只处理新模块
+                scan->skip = self->modules_.size();
+            } else {
+                self->modules_.clear();
+                self->by_path_.clear();
+                self->by_soname_.clear();
+                self->by_file_.clear();
+                self->bases_.clear();
+            }
+            self->valid_ = has_counters;
+            if (has_counters) {
+                self->adds_ = info->dlpi_adds;
+                self->subs_ = info->dlpi_subs;
+            }
+        }
+
+        if (scan->index++ < scan->skip) return 0;
+        self->bases_.push_back(info->dlpi_addr);
+
+        Module module;
+        module.path = info->dlpi_name ? info->dlpi_name : "";
+        module.base = reinterpret_cast<void*>(info->dlpi_addr);
+        module.soname = readSoname(info);
+        if (module.soname.empty() && !module.path.empty()) {
+            size_t slash = module.path.rfind('/');
+            module.soname = slash == std::string::npos ? module.path : module.path.substr(slash + 1);
+        }
+
+        struct stat st;
+        if (!module.path.empty() && module.path[0] == '/' && stat(module.path.c_str(), &st) == 0) {
+            module.dev = st.st_dev;
+            module.ino = st.st_ino;
+        }
+
+        self->addModule(std::move(module));
+        return 0;
+    }, &scan);
+
+    snapshot_taken_ = true;
+    if (!scan.unchanged) {
+        generation_++;
+        LOGD("Link map snapshot: %zu modules", modules_.size());
+    }
+}
+
+uint64_t LinkMap::generation() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return generation_;
+}
+
+void* LinkMap::findBase(std::string_view path, const struct stat* st) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = by_path_.find(std::string(path));
+    if (it != by_path_.end()) return modules_[it->second].base;
+
+    if (st) {
+        auto fit = by_file_.find(FileKey{st->st_dev, st->st_ino});
+        if (fit != by_file_.end()) return modules_[fit->second].base;
+    }
+    return nullptr;
+}
+
+void* LinkMap::findSoname(std::string_view soname, std::string* out_path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = by_soname_.find(std::string(soname));
+    if (it == by_soname_.end()) return nullptr;
+
+    auto& module = modules_[it->second];
+    if (out_path) *out_path = module.path;
+    return module.base;
+}
+
+} // namespace soloader
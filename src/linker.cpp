@@ -1,18 +1,25 @@
 // Modern C++17 SO Loader - Linker Implementation (arm64 only)
 
 #include "linker.hpp"
+#include "load_context.hpp"
+#include "batch_io.hpp"
+#include "search_path.hpp"
+#include "link_map.hpp"
+#include "system_symbols.hpp"
+#include "interpose.hpp"
+#include "dep_registry.hpp"
 #include "tls.hpp"
 #include "backtrace.hpp"
 #include "sleb128.hpp"
 #include "log.hpp"
-#include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
-#include <sys/auxv.h>
 #include <cstring>
 #include <dlfcn.h>
 #include <set>
+#include <unordered_set>
+#include <algorithm>
 
 namespace soloader {
 
@@ -109,35 +116,53 @@ bool Linker::init(std::unique_ptr<ElfImage> image) {
     is_linked_ = false;
     main_map_size_ = 0;
     deps_.clear();
+    system_scope_.clear();
+    overrides_.clear();
+    import_slots_.clear();
+    import_index_.clear();
+    scope_images_.clear();
+    scope_filter_.clear();
+    text_writes_.clear();
+    tls_providers_.clear();
+    constructors_pending_ = false;
+    main_is_root_ = false;
     return true;
 }
 
 void Linker::destroy() {
-    // 主库析构（主库依赖于依赖库，所以主库析构函数必须先执行）
-    if (main_image_ && is_linked_) {
+    // 主库析构（主库依赖于依赖库，所以主库析构函数必须先执行）；推迟后尚未构造的镜像不析构
+    auto destroyMain = [&] {
+        if (!main_image_ || !is_linked_) return;
         BacktraceManager::instance().unregisterEhFrame(main_image_.get());
         BacktraceManager::instance().unregisterLibrary(main_image_.get());
-        callDestructors(main_image_.get());
-    }
-
-    // 逆序调用依赖的析构函数
-    for (auto it = deps_.rbegin(); it != deps_.rend(); ++it) {
-        if (it->image && it->is_manual_load && is_linked_) {
-            BacktraceManager::instance().unregisterEhFrame(it->image.get());
-            BacktraceManager::instance().unregisterLibrary(it->image.get());
-            callDestructors(it->image.get());
+        if (!(constructors_pending_ && pending_main_)) callDestructors(main_image_.get());
+    };
+    if (!main_is_root_) destroyMain();
+
+    // 逆序调用依赖的析构函数：先按加载逆序析构命名空间中显式加载的库（主库是其中第一个），
+    // 再析构其余依赖（共享的依赖由最后一个引用方析构）
+    for (bool roots : {true, false}) {
+        for (size_t i = deps_.size(); i > 0; i--) {
+            auto& dep = deps_[i - 1];
+            if (dep.root != roots) continue;
+            if (dep.image && dep.is_manual_load && !dep.shared && is_linked_) {
+                BacktraceManager::instance().unregisterEhFrame(dep.image.get());
+                BacktraceManager::instance().unregisterLibrary(dep.image.get());
+                if (!(constructors_pending_ && i - 1 >= pending_dep_)) callDestructors(dep.image.get());
+            }
         }
+        if (roots && main_is_root_) destroyMain();
     }
 
     // 释放 TLSDESC 分配的 TlsIndex
-    for (auto* ti : tls_indices_) {
+    for (auto& [image, ti] : tls_indices_) {
         delete ti;
     }
     tls_indices_.clear();
 
     // 注销 TLS 段
     for (auto it = deps_.rbegin(); it != deps_.rend(); ++it) {
-        if (it->image) {
+        if (it->image && !it->shared) {
             TlsManager::instance().unregisterSegment(it->image.get());
         }
     }
@@ -145,12 +170,20 @@ void Linker::destroy() {
         TlsManager::instance().unregisterSegment(main_image_.get());
     }
 
+    releaseSystemHandles();
+    scope_images_.clear();
+    scope_filter_.clear();
+    import_slots_.clear();
+    import_index_.clear();
+    tls_providers_.clear();
+
     // 释放依赖
     for (auto& dep : deps_) {
-        if (dep.is_manual_load && dep.map_size > 0) {
+        if (dep.is_manual_load && !dep.shared && dep.map_size > 0) {
             munmap(dep.map_base, dep.map_size);
         }
     }
+    releaseSharedDependencies();
     deps_.clear();
 
     // 释放主库
@@ -160,6 +193,7 @@ void Linker::destroy() {
     main_image_.reset();
 
     is_linked_ = false;
+    constructors_pending_ = false;
     main_map_size_ = 0;
 }
 
@@ -167,7 +201,7 @@ void Linker::abandon() {
     // 类似 destroy 但不调用析构函数
     if (is_linked_) {
         for (auto& dep : deps_) {
-            if (dep.image && dep.is_manual_load) {
+            if (dep.image && dep.is_manual_load && !dep.shared) {
                 BacktraceManager::instance().unregisterEhFrame(dep.image.get());
                 BacktraceManager::instance().unregisterLibrary(dep.image.get());
             }
@@ -180,14 +214,14 @@ void Linker::abandon() {
     }
 
     // 释放 TLSDESC 分配的 TlsIndex
-    for (auto* ti : tls_indices_) {
+    for (auto& [image, ti] : tls_indices_) {
         delete ti;
     }
     tls_indices_.clear();
 
     // 注销 TLS 段
     for (auto it = deps_.rbegin(); it != deps_.rend(); ++it) {
-        if (it->image) {
+        if (it->image && !it->shared) {
             TlsManager::instance().unregisterSegment(it->image.get());
         }
     }
@@ -195,12 +229,30 @@ void Linker::abandon() {
         TlsManager::instance().unregisterSegment(main_image_.get());
     }
 
+    // 共享依赖的引用不释放：其映射与其他使用方一样保留到进程结束
+    releaseSystemHandles();
+    scope_images_.clear();
+    scope_filter_.clear();
+    import_slots_.clear();
+    import_index_.clear();
+    tls_providers_.clear();
     deps_.clear();
     main_image_.reset();
     is_linked_ = false;
+    constructors_pending_ = false;
     main_map_size_ = 0;
 }
 
+void Linker::releaseSystemHandles() {
+    system_scope_.clear();
+    for (auto& dep : deps_) {
+        if (dep.handle) {
+            dlclose(dep.handle);
+            dep.handle = nullptr;
+        }
+    }
+}
+
 static size_t getLoadSize(const ElfPhdr* phdr, size_t count, ElfAddr* min_vaddr) {
     ElfAddr lo = UINTPTR_MAX, hi = 0;
     
@@ -217,7 +269,9 @@ static size_t getLoadSize(const ElfPhdr* phdr, size_t count, ElfAddr* min_vaddr)
     return hi - lo;
 }
 
-static int loadSegment(int fd, ElfPhdr* phdr, ElfAddr bias) {
+// 每个段直接以最终保护映射：文件部分一次 mmap，超出文件页的 BSS 再一次匿名 mmap。
+// 新的匿名页天然为零，不做任何写入，保持按需分配；只清零文件末页的尾部。
+static int loadSegment(int fd, const ElfPhdr* phdr, ElfAddr bias) {
     auto seg_start = phdr->p_vaddr + bias;
     auto seg_end = seg_start + phdr->p_memsz;
     auto file_end = seg_start + phdr->p_filesz;
@@ -232,10 +286,6 @@ static int loadSegment(int fd, ElfPhdr* phdr, ElfAddr bias) {
     if (phdr->p_flags & PF_W) prot |= PROT_WRITE;
     if (phdr->p_flags & PF_X) prot |= PROT_EXEC;
     
-    // W+X 需要特殊处理
-    bool needs_mprotect = (prot & PROT_WRITE) && (prot & PROT_EXEC);
-    if (needs_mprotect) prot &= ~PROT_EXEC;
-    
     // 映射文件内容
     if (file_len > 0) {
         if (mmap(reinterpret_cast<void*>(pg_start), file_len, prot,
@@ -245,7 +295,13 @@ static int loadSegment(int fd, ElfPhdr* phdr, ElfAddr bias) {
         }
     }
     
-    // BSS 段
+    // 清零文件末页中超出 p_filesz 的部分（仅可写段，与 bionic 一致）
+    if ((phdr->p_flags & PF_W) && file_end < seg_end && (file_end & (pageSize() - 1))) {
+        auto zero_len = std::min(pageEnd(file_end), seg_end) - file_end;
+        memset(reinterpret_cast<void*>(file_end), 0, zero_len);
+    }
+    
+    // BSS 段：替换预留区域为可访问的匿名页，不触碰页面
     if (pg_end > pg_start + file_len) {
         auto bss_addr = reinterpret_cast<void*>(pg_start + file_len);
         auto bss_size = pg_end - (pg_start + file_len);
@@ -255,54 +311,34 @@ static int loadSegment(int fd, ElfPhdr* phdr, ElfAddr bias) {
             PLOGE("mmap BSS");
             return -1;
         }
-        memset(bss_addr, 0, bss_size);
-    }
-    
-    // 清零文件末尾到页边界
-    if ((phdr->p_flags & PF_W) && file_end < seg_end) {
-        auto zero_start = file_end;
-        auto zero_len = std::min(pageEnd(file_end) - file_end, seg_end - file_end);
-        memset(reinterpret_cast<void*>(zero_start), 0, zero_len);
-    }
-    
-    // 恢复 EXEC
-    if (needs_mprotect) {
-        mprotect(reinterpret_cast<void*>(pg_start), pg_end - pg_start, prot | PROT_EXEC);
     }
     
     return 0;
 }
 
 void* Linker::loadLibraryManually(std::string_view path, LoadedDep& dep) {
+    LoadContext ctx;
+    if (!ctx.open(path)) return nullptr;
+    return loadLibraryManually(ctx, dep);
+}
+
+void* Linker::loadLibraryManually(LoadContext& ctx, LoadedDep& dep) {
     pageSize(); // 确保初始化
     
-    int fd = open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC);
-    if (fd < 0) {
-        PLOGE("open %.*s", static_cast<int>(path.size()), path.data());
-        return nullptr;
-    }
-    
-    ElfEhdr eh;
-    if (pread(fd, &eh, sizeof(eh), 0) != sizeof(eh)) {
-        LOGE("Failed to read ELF header");
-        close(fd);
-        return nullptr;
-    }
-    
-    size_t phdr_size = eh.e_phnum * sizeof(ElfPhdr);
-    auto phdr = std::make_unique<ElfPhdr[]>(eh.e_phnum);
+    // 头部直接从共享的文件镜像解析，ElfImage 随后接管同一份镜像
+    if (!ctx.readImage()) return nullptr;
     
-    if (pread(fd, phdr.get(), phdr_size, eh.e_phoff) != static_cast<ssize_t>(phdr_size)) {
+    auto* phdr = ctx.programHeaders();
+    if (!phdr) {
         LOGE("Failed to read program headers");
-        close(fd);
         return nullptr;
     }
+    size_t phnum = ctx.header()->e_phnum;
     
     ElfAddr min_vaddr;
-    dep.map_size = getLoadSize(phdr.get(), eh.e_phnum, &min_vaddr);
+    dep.map_size = getLoadSize(phdr, phnum, &min_vaddr);
     if (dep.map_size == 0) {
         LOGE("No loadable segments");
-        close(fd);
         return nullptr;
     }
     
@@ -311,24 +347,20 @@ void* Linker::loadLibraryManually(std::string_view path, LoadedDep& dep) {
                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
     if (base == MAP_FAILED) {
         PLOGE("mmap reserve");
-        close(fd);
         return nullptr;
     }
     
     ElfAddr bias = reinterpret_cast<ElfAddr>(base) - min_vaddr;
     
     // 加载各段
-    for (int i = 0; i < eh.e_phnum; i++) {
+    for (size_t i = 0; i < phnum; i++) {
         if (phdr[i].p_type != PT_LOAD) continue;
-        if (loadSegment(fd, &phdr[i], bias) != 0) {
+        if (loadSegment(ctx.fd(), &phdr[i], bias) != 0) {
             munmap(base, dep.map_size);
-            close(fd);
             return nullptr;
         }
     }
     
-    close(fd);
-    
     dep.is_manual_load = true;
     dep.map_base = base;
     
@@ -336,67 +368,20 @@ void* Linker::loadLibraryManually(std::string_view path, LoadedDep& dep) {
 }
 
 bool Linker::findLibraryPath(std::string_view name, std::string& out) {
-    // 如果是绝对路径，直接使用
-    if (!name.empty() && name[0] == '/') {
-        out = name;
-        if (access(out.c_str(), F_OK) == 0) return true;
-        LOGE("Library not found at absolute path: %s", out.c_str());
-        return false;
-    }
-    
-    // Android 库搜索路径（按优先级排序）
-    static const char* search_paths[] = {
-        // APEX 运行时库（Android 10+）
-        "/apex/com.android.runtime/lib64/bionic/",
-        "/apex/com.android.runtime/lib64/",
-        "/apex/com.android.art/lib64/",
-        // 系统库
-        "/system/lib64/",
-        "/system/lib64/vndk/",
-        "/system/lib64/vndk-sp/",
-        // 供应商库
-        "/vendor/lib64/",
-        "/vendor/lib64/vndk/",
-        "/vendor/lib64/vndk-sp/",
-        // ODM 库
-        "/odm/lib64/",
-        // 产品库
-        "/product/lib64/",
-        // 系统扩展库
-        "/system_ext/lib64/",
-        nullptr
-    };
-    
-    // 特殊库名映射
-    std::string actual_name(name);
-    
-    // libc++.so 可能有不同的位置
-    if (name == "libc++.so") {
-        // 优先检查 APEX
-        out = "/apex/com.android.runtime/lib64/libc++.so";
-        if (access(out.c_str(), F_OK) == 0) return true;
-        
-        out = "/system/lib64/libc++.so";
-        if (access(out.c_str(), F_OK) == 0) return true;
-    }
-    
-    // 搜索所有路径
-    for (int i = 0; search_paths[i]; i++) {
-        out = std::string(search_paths[i]) + actual_name;
-        if (access(out.c_str(), F_OK) == 0) {
-            LOGD("Found library: %s", out.c_str());
-            return true;
-        }
+    if (LibrarySearchPath::instance().find(name, out)) {
+        LOGD("Found library: %s", out.c_str());
+        return true;
     }
     
     LOGE("Library not found: %.*s", static_cast<int>(name.size()), name.data());
     return false;
 }
 
-bool Linker::isLoaded(std::string_view path) {
+bool Linker::isLoaded(std::string_view path, const struct stat* st) {
     if (main_image_ && main_image_->path() == path) return true;
     for (auto& dep : deps_) {
         if (dep.image && dep.image->path() == path) return true;
+        if (st && dep.ino && dep.dev == st->st_dev && dep.ino == st->st_ino) return true;
     }
     return false;
 }
@@ -428,53 +413,145 @@ SymbolLookup Linker::findSymbolCached(std::string_view name) {
     return result;
 }
 
-SymbolLookup Linker::findSymbol(std::string_view name) {
+void Linker::buildScopeFilter() {
+    scope_images_.clear();
+    scope_filter_.clear();
+    scope_unfiltered_.clear();
+    
+    if (main_image_) scope_images_.push_back(main_image_.get());
+    for (auto& dep : deps_) {
+        if (dep.image) scope_images_.push_back(dep.image.get());
+    }
+    
+    size_t total = 0;
+    for (auto* image : scope_images_) {
+        image->forEachDefinedName([&](std::string_view) { total++; });
+    }
+    
+    // 约 2 倍符号数的槽位，单个镜像的误判率约为其符号数 / 槽位数。
+    // 每个槽位 scope_words_ 个 64 位字，镜像数不受限制（命名空间可能有上百个镜像）
+    size_t size = 64;
+    while (size < total * 2 && size < (size_t(1) << 16)) size <<= 1;
+    scope_words_ = (scope_images_.size() + 63) / 64;
+    scope_filter_.assign(size * scope_words_, 0);
+    scope_unfiltered_.assign(scope_words_, 0);
+    
+    for (size_t i = 0; i < scope_images_.size(); i++) {
+        size_t word = i / 64;
+        uint64_t bit = uint64_t(1) << (i % 64);
+        bool complete = scope_images_[i]->forEachDefinedName([&](std::string_view name) {
+            scope_filter_[(gnuHash(name) & (size - 1)) * scope_words_ + word] |= bit;
+        });
+        if (!complete) scope_unfiltered_[word] |= bit;
+    }
+    
+    LOGD("Scope filter: %zu images, %zu names, %zu slots", scope_images_.size(), total, size);
+}
+
+SymbolLookup Linker::findImageSymbol(std::string_view name, uint32_t hash) {
     SymbolLookup weak_result;  // 保存第一个弱符号结果
+    SymbolLookup strong_result;
 
-    // 先在主库查找
-    if (main_image_) {
+    // 返回 true 表示找到强符号（GLOBAL），搜索结束；弱符号保存但继续查找更强的符号
+    auto probe = [&](ElfImage* image) {
         uint8_t sym_bind = 0;
-        if (auto addr = main_image_->findSymbolAddress(name, &sym_bind)) {
-            SymbolLookup found = {reinterpret_cast<void*>(*addr), main_image_.get(), sym_bind, 0};
+        auto addr = image->findSymbolAddress(name, hash, &sym_bind);
+        if (!addr) return false;
 
-            // 如果是强符号（GLOBAL），直接返回
-            if (sym_bind != STB_WEAK) {
-                return found;
-            }
-            // 如果是弱符号，保存但继续查找更强的符号
-            if (!weak_result.valid()) {
-                weak_result = found;
-            }
+        SymbolLookup found = {reinterpret_cast<void*>(*addr), image, sym_bind, 0};
+        if (sym_bind != STB_WEAK) {
+            strong_result = found;
+            return true;
         }
-    }
-
-    // 在依赖中查找
-    for (auto& dep : deps_) {
-        if (!dep.image) continue;
-
-        uint8_t sym_bind = 0;
-        if (auto addr = dep.image->findSymbolAddress(name, &sym_bind)) {
-            SymbolLookup found = {reinterpret_cast<void*>(*addr), dep.image.get(), sym_bind, 0};
+        if (!weak_result.valid()) {
+            weak_result = found;
+        }
+        return false;
+    };
 
-            // 如果是强符号，直接返回
-            if (sym_bind != STB_WEAK) {
-                return found;
-            }
-            // 如果是弱符号，保存但继续查找更强的符号
-            if (!weak_result.valid()) {
-                weak_result = found;
+    if (!scope_filter_.empty()) {
+        // 只访问可能定义该符号的镜像，位序即主库、依赖的原始优先级
+        size_t slots = scope_filter_.size() / scope_words_;
+        const uint64_t* words = &scope_filter_[(hash & (slots - 1)) * scope_words_];
+        for (size_t w = 0; w < scope_words_; w++) {
+            uint64_t candidates = words[w] | scope_unfiltered_[w];
+            while (candidates) {
+                size_t i = w * 64 + __builtin_ctzll(candidates);
+                candidates &= candidates - 1;
+                if (probe(scope_images_[i])) return strong_result;
             }
         }
+    } else {
+        // 先在主库查找，再按顺序在依赖中查找
+        if (main_image_ && probe(main_image_.get())) return strong_result;
+        for (auto& dep : deps_) {
+            if (dep.image && probe(dep.image.get())) return strong_result;
+        }
     }
 
     // 如果有弱符号结果，返回它
     if (weak_result.valid()) {
         LOGD("Using weak symbol for '%.*s'", static_cast<int>(name.size()), name.data());
-        return weak_result;
     }
+    return weak_result;
+}
+
+void Linker::setSymbolOverrides(const std::vector<std::pair<std::string_view, void*>>& overrides) {
+    overrides_.clear();
+    for (auto& [name, address] : overrides) {
+        overrides_.push_back({std::string(name), gnuHash(name), address});
+    }
+}
+
+void* Linker::findOverride(std::string_view name, uint32_t hash) const {
+    for (auto& entry : overrides_) {
+        if (entry.hash == hash && entry.name == name) return entry.address;
+    }
+    return InterposeTable::instance().find(name, hash);
+}
+
+void Linker::dropUnsafeOverrides() {
+    auto is_new_delete = [](std::string_view name) {
+        return name.rfind("_Znw", 0) == 0 || name.rfind("_Zna", 0) == 0 ||
+               name.rfind("_Zdl", 0) == 0 || name.rfind("_Zda", 0) == 0;
+    };
+    if (std::none_of(overrides_.begin(), overrides_.end(),
+                     [&](const SymbolOverride& entry) { return is_new_delete(entry.name); })) {
+        return;
+    }
+
+    // 系统已加载的库（如 libc++_shared.so）的 operator new/delete 不经过替换表：
+    // 库内联分配、系统库释放（或反过来）的对象会被交给错误的分配器
+    for (auto& dep : deps_) {
+        if (dep.is_manual_load || !dep.image) continue;
+        std::string_view conflict;
+        auto check = [&](std::string_view name) {
+            if (conflict.empty() && is_new_delete(name)) conflict = name;
+        };
+        dep.image->forEachImportedName(check);
+        dep.image->forEachDefinedName(check);
+        if (!conflict.empty()) {
+            LOGW("%s uses %.*s from the system allocator, symbol overrides disabled",
+                 dep.image->path().c_str(), static_cast<int>(conflict.size()), conflict.data());
+            overrides_.clear();
+            return;
+        }
+    }
+}
+
+SymbolLookup Linker::findSymbol(std::string_view name) {
+    uint32_t hash = gnuHash(name);
     
-    // 尝试从系统库查找（通过 dlsym）
-    void* sys_addr = dlsym(RTLD_DEFAULT, std::string(name).c_str());
+    // 替换表优先于所有镜像和系统库
+    if (void* addr = findOverride(name, hash)) {
+        return {addr, nullptr, STB_GLOBAL, 0};
+    }
+    
+    auto result = findImageSymbol(name, hash);
+    if (result.valid()) return result;
+    
+    // 尝试从系统库查找
+    void* sys_addr = findSystemSymbol(name);
     if (sys_addr) {
         LOGD("Found symbol '%.*s' in system libraries", 
              static_cast<int>(name.size()), name.data());
@@ -485,41 +562,99 @@ SymbolLookup Linker::findSymbol(std::string_view name) {
     return {};
 }
 
-bool Linker::loadDependencies() {
-    std::set<std::string> loaded_names;
-    std::vector<std::string> to_load;
+void* Linker::findSystemSymbol(std::string_view name) {
+    // 按 DT_NEEDED（BFS）顺序只搜索本库依赖的系统库及其依赖树，最后回退到全局作用域；
+    // 结果（包括未找到）由进程级缓存共享
+    return SystemSymbolCache::instance().resolve(system_scope_, name);
+}
 
-    // 辅助函数：从动态段获取字符串表和 DT_NEEDED 列表
-    auto collectNeeded = [](ElfImage* img, ElfDyn* dyn,
-                            std::set<std::string>& names,
-                            std::vector<std::string>& out) {
-        if (!dyn) return;
-
-        // 优先使用 DT_STRTAB（运行时地址），回退到节区头 strtab
-        const char* strtab = nullptr;
-        for (auto* d = dyn; d->d_tag != DT_NULL; d++) {
-            if (d->d_tag == DT_STRTAB) {
-                strtab = reinterpret_cast<const char*>(
-                    reinterpret_cast<uintptr_t>(img->base()) + d->d_un.d_ptr - img->bias());
-                break;
-            }
+void Linker::preresolveImports(size_t first_dep, bool with_main) {
+    // 收集主库和手动加载依赖的全部导入符号（去重）
+    std::vector<std::string_view> imports;
+    std::unordered_set<std::string_view> seen;
+    auto collect = [&](ElfImage* img) {
+        auto* dynsym = img->dynsymStart();
+        auto* shdr = img->dynsymShdr();
+        auto* strtab = img->strtabStart();
+        if (!dynsym || !shdr || !strtab || shdr->sh_entsize != sizeof(ElfSym)) return;
+
+        size_t count = shdr->sh_size / sizeof(ElfSym);
+        for (size_t i = 1; i < count; i++) {
+            auto& sym = dynsym[i];
+            if (sym.st_shndx != SHN_UNDEF || !sym.st_name) continue;
+            if (elf_st_bind(sym.st_info) == STB_LOCAL) continue;
+            std::string_view name = strtab + sym.st_name;
+            if (seen.insert(name).second) imports.push_back(name);
         }
-        if (!strtab) strtab = img->strtabStart();
-        if (!strtab) return;
+    };
+    if (with_main) collect(main_image_.get());
+    for (size_t i = first_dep; i < deps_.size(); i++) {
+        if (deps_[i].is_manual_load && !deps_[i].shared) collect(deps_[i].image.get());
+    }
 
-        for (auto* d = dyn; d->d_tag != DT_NULL; d++) {
-            if (d->d_tag == DT_NEEDED) {
-                std::string name = strtab + d->d_un.d_val;
-                if (names.insert(name).second) {
-                    out.push_back(name);
-                }
-            }
+    // 先在已加载镜像中解析，剩余的整批交给系统符号缓存
+    std::vector<std::pair<std::string_view, SymbolLookup>> resolved;
+    std::vector<std::string_view> system_names;
+    resolved.reserve(imports.size());
+    for (auto name : imports) {
+        uint32_t hash = gnuHash(name);
+        if (void* addr = findOverride(name, hash)) {
+            resolved.emplace_back(name, SymbolLookup{addr, nullptr, STB_GLOBAL, 0});
+            continue;
         }
-    };
+        auto result = findImageSymbol(name, hash);
+        if (result.valid()) {
+            resolved.emplace_back(name, result);
+        } else {
+            system_names.push_back(name);
+        }
+    }
+
+    std::vector<void*> addrs;
+    SystemSymbolCache::instance().resolveBatch(system_scope_, system_names, addrs);
+    for (size_t i = 0; i < system_names.size(); i++) {
+        resolved.emplace_back(system_names[i], SymbolLookup{addrs[i], nullptr, STB_GLOBAL, 0});
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    for (auto& [name, result] : resolved) {
+        symbol_cache_.emplace(std::string(name), SymbolCacheEntry{result.address, result.image, result.valid()});
+    }
+    LOGD("Preresolved %zu imports (%zu via system libraries)", imports.size(), system_names.size());
+}
+
+struct PrefetchedLibrary {
+    std::string path;   // 为空表示未找到
+    LoadContext ctx;
+};
+using PrefetchMap = std::unordered_map<std::string, PrefetchedLibrary>;
+
+// 依赖名一经发现立即解析路径、打开并提示内核预读（POSIX_FADV_WILLNEED）。
+// 打开的 fd 保留到该层处理时直接复用
+static void prefetchLibraries(const std::vector<std::string>& names, size_t first,
+                              PrefetchMap& out) {
+    if (first >= names.size()) return;
+
+    auto& search = LibrarySearchPath::instance();
+    auto& link_map = LinkMap::instance();
+    for (size_t i = first; i < names.size(); i++) {
+        auto& entry = out[names[i]];
+        if (!search.find(names[i], entry.path) && !link_map.findSoname(names[i], &entry.path)) {
+            entry.path.clear();
+            continue;
+        }
+
+        if (entry.ctx.open(entry.path)) {
+            entry.ctx.adviseWillNeed();
+        }
+    }
+}
 
-    // 收集主库的依赖
-    auto* header = main_image_->header();
-    if (!header->e_phoff) return true;
+// 从动态段读取镜像的 DT_NEEDED 列表（按出现顺序）
+static std::vector<std::string> neededLibraries(ElfImage* img) {
+    std::vector<std::string> out;
+    auto* header = img->header();
+    if (!header->e_phoff) return out;
 
     auto* phdr = reinterpret_cast<ElfPhdr*>(
         reinterpret_cast<uintptr_t>(header) + header->e_phoff);
@@ -528,75 +663,190 @@ bool Linker::loadDependencies() {
     for (int i = 0; i < header->e_phnum; i++) {
         if (phdr[i].p_type == PT_DYNAMIC) {
             dyn = reinterpret_cast<ElfDyn*>(
-                reinterpret_cast<uintptr_t>(main_image_->base()) +
-                phdr[i].p_vaddr - main_image_->bias());
+                reinterpret_cast<uintptr_t>(img->base()) + phdr[i].p_vaddr - img->bias());
+            break;
+        }
+    }
+    if (!dyn) return out;
+
+    // 优先使用 DT_STRTAB（运行时地址），回退到节区头 strtab
+    const char* strtab = nullptr;
+    for (auto* d = dyn; d->d_tag != DT_NULL; d++) {
+        if (d->d_tag == DT_STRTAB) {
+            strtab = reinterpret_cast<const char*>(
+                reinterpret_cast<uintptr_t>(img->base()) + d->d_un.d_ptr - img->bias());
             break;
         }
     }
+    if (!strtab) strtab = img->strtabStart();
+    if (!strtab) return out;
 
-    collectNeeded(main_image_.get(), dyn, loaded_names, to_load);
+    for (auto* d = dyn; d->d_tag != DT_NULL; d++) {
+        if (d->d_tag == DT_NEEDED) out.emplace_back(strtab + d->d_un.d_val);
+    }
+    return out;
+}
 
-    // 递归加载依赖
-    for (size_t i = 0; i < to_load.size(); i++) {
-        std::string full_path;
-        if (!findLibraryPath(to_load[i], full_path)) {
-            LOGW("Skipping missing library: %s", to_load[i].c_str());
-            continue;
+bool Linker::loadDependencies(const std::vector<ElfImage*>& roots) {
+    std::set<std::string> loaded_names;
+    std::vector<std::string> to_load;
+
+    // 辅助函数：收集尚未见过的 DT_NEEDED
+    auto collectNeeded = [](ElfImage* img, std::set<std::string>& names,
+                            std::vector<std::string>& out) {
+        for (auto& name : neededLibraries(img)) {
+            if (names.insert(name).second) {
+                out.push_back(std::move(name));
+            }
         }
+    };
 
-        if (isLoaded(full_path)) continue;
+    // 收集根镜像（主库，以及同批加入命名空间的库）的依赖
+    for (auto* root : roots) {
+        collectNeeded(root, loaded_names, to_load);
+    }
 
-        LoadedDep dep;
+    // 按 BFS 层加载依赖：路径由搜索目录索引解析，整层的打开和读取合并为一次批量提交，
+    // deps_ 的顺序与逐个加载时一致。新发现的依赖立即预读，磁盘 I/O 与本层剩余库的解析重叠
+    // 搜索目录索引每次链接只校验一次 mtime，之后的路径解析均在内存中完成
+    auto& search = LibrarySearchPath::instance();
+    search.refresh();
+
+    // 进程链接表每次链接只同步一次，之后 "是否已被系统加载" 为 O(1) 查找
+    auto& link_map = LinkMap::instance();
+    link_map.refresh();
+    SystemSymbolCache::instance().sync(link_map.generation());
+
+    std::vector<std::string> level = std::move(to_load);
+    PrefetchMap prefetched;
+    while (!level.empty()) {
+        std::vector<std::string> paths(level.size());
+        std::vector<LoadContext> contexts(level.size());
+
+        // 1. 解析本层路径（已预读的直接复用其路径和 fd）
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < level.size(); i++) {
+            auto it = prefetched.find(level[i]);
+            if (it == prefetched.end()) {
+                pending.push_back(i);
+                continue;
+            }
+            paths[i] = std::move(it->second.path);
+            contexts[i] = std::move(it->second.ctx);
+            prefetched.erase(it);
+        }
 
-        // 尝试使用系统已加载的库
-        auto check = ElfImage::create(full_path, nullptr);
-        if (check && check->base()) {
-            dep.image = std::move(check);
-            dep.is_manual_load = false;
-        } else {
-            // 手动加载
-            void* base = loadLibraryManually(full_path, dep);
-            if (!base) {
-                LOGE("Failed to load: %s", full_path.c_str());
-                return false;
+        // 搜索目录中没有，但系统链接器已按 soname 加载（如应用私有目录中的库）时使用其路径；
+        // 预读的更深层依赖在 prefetchLibraries 中做同样的回退
+        for (size_t i : pending) {
+            if (search.find(level[i], paths[i])) continue;
+            if (!link_map.findSoname(level[i], &paths[i])) paths[i].clear();
+        }
+
+        // 2. 批量打开并读取尚未打开的库
+        std::vector<size_t> to_open;
+        std::vector<std::string> open_paths;
+        for (size_t i = 0; i < level.size(); i++) {
+            if (paths[i].empty() || contexts[i].isOpen() || isLoaded(paths[i])) continue;
+            to_open.push_back(i);
+            open_paths.push_back(paths[i]);
+        }
+
+        std::vector<LoadContext> opened;
+        BatchIo::instance().openAndRead(open_paths, opened);
+        for (size_t k = 0; k < to_open.size(); k++) {
+            contexts[to_open[k]] = std::move(opened[k]);
+        }
+
+        // 3. 按原顺序映射、解析
+        std::vector<std::string> next_level;
+        for (size_t i = 0; i < level.size(); i++) {
+            const std::string& full_path = paths[i];
+            auto& ctx = contexts[i];
+            if (full_path.empty()) {
+                LOGW("Skipping missing library: %s", level[i].c_str());
+                continue;
             }
-            dep.image = ElfImage::create(full_path, base);
-            if (!dep.image) {
-                munmap(base, dep.map_size);
+            if (isLoaded(full_path)) continue;
+            if (!ctx.isOpen()) {
+                LOGE("Failed to load: %s", full_path.c_str());
                 return false;
             }
-            dep.is_manual_load = true;
-        }
-
-        // 收集该依赖的依赖
-        if (dep.is_manual_load && dep.image->header()->e_phoff) {
-            auto* dep_header = dep.image->header();
-            auto* dep_phdr = reinterpret_cast<ElfPhdr*>(
-                reinterpret_cast<uintptr_t>(dep_header) + dep_header->e_phoff);
-
-            ElfDyn* dep_dyn = nullptr;
-            for (int j = 0; j < dep_header->e_phnum; j++) {
-                if (dep_phdr[j].p_type == PT_DYNAMIC) {
-                    dep_dyn = reinterpret_cast<ElfDyn*>(
-                        reinterpret_cast<uintptr_t>(dep.image->base()) +
-                        dep_phdr[j].p_vaddr - dep.image->bias());
-                    break;
+            // 经不同路径（如同批加入的库被另一个库按 soname 引用）到达的同一文件
+            if (isLoaded(full_path, &ctx.fileStat())) continue;
+
+            LoadedDep dep;
+
+            // 尝试使用系统已加载的库（复用已读入的文件镜像）
+            if (void* sys_base = link_map.findBase(full_path, &ctx.fileStat())) {
+                dep.image = ElfImage::create(ctx, sys_base);
+                if (!dep.image) {
+                    LOGE("Failed to parse: %s", full_path.c_str());
+                    return false;
                 }
+                dep.is_manual_load = false;
+
+                // 持有句柄用于定向符号查找；命名空间限制导致失败时回退到 RTLD_DEFAULT
+                dep.handle = dlopen(full_path.c_str(), RTLD_NOW | RTLD_NOLOAD);
+                if (dep.handle) {
+                    system_scope_.push_back(dep.handle);
+                } else {
+                    LOGD("dlopen(RTLD_NOLOAD) failed for %s: %s", full_path.c_str(), dlerror());
+                }
+            } else {
+                // 其他链接器已链接的同一文件（dev/inode 与 build-id 一致）直接复用
+                SharedDependency* shared = nullptr;
+                if (share_deps_ && overrides_.empty() && ctx.readImage()) {
+                    shared = DependencyRegistry::instance().acquire(
+                        ctx.fileStat(), findBuildId(ctx.header(), ctx.fileSize()));
+                }
+                if (shared) {
+                    LOGD("Reusing shared %s", shared->image->path().c_str());
+                    dep.image = shared->image;
+                    dep.map_base = shared->map_base;
+                    dep.map_size = shared->map_size;
+                    dep.shared = shared;
+                } else {
+                    // 手动加载：fd 与文件镜像贯穿映射和解析
+                    void* base = loadLibraryManually(ctx, dep);
+                    if (!base) {
+                        LOGE("Failed to load: %s", full_path.c_str());
+                        return false;
+                    }
+                    dep.image = ElfImage::create(ctx, base);
+                    if (!dep.image) {
+                        munmap(base, dep.map_size);
+                        return false;
+                    }
+                }
+                dep.is_manual_load = true;
+                dep.dev = ctx.fileStat().st_dev;
+                dep.ino = ctx.fileStat().st_ino;
             }
+            ctx.close();
 
-            collectNeeded(dep.image.get(), dep_dyn, loaded_names, to_load);
+            // 收集该依赖的依赖（进入下一层），并立即预读
+            if (dep.is_manual_load) {
+                size_t first_new = next_level.size();
+                collectNeeded(dep.image.get(), loaded_names, next_level);
+                prefetchLibraries(next_level, first_new, prefetched);
+            }
+
+            deps_.push_back(std::move(dep));
         }
 
-        deps_.push_back(std::move(dep));
+        level = std::move(next_level);
     }
 
     return true;
 }
 
-void Linker::processRelocation(ElfImage* /*image*/, uint32_t sym_idx, uint32_t type,
+void Linker::processRelocation(ElfImage* image, uint32_t sym_idx, uint32_t type,
                                ElfAddr offset, ElfAddr addend, ElfAddr load_bias,
                                ElfSym* dynsym, const char* dynstr, bool is_rela) {
     auto* target = reinterpret_cast<ElfAddr*>(load_bias + offset);
+    noteTextWrite(reinterpret_cast<uintptr_t>(target),
+                  type == R_AARCH64_TLSDESC ? 2 * sizeof(ElfAddr) : sizeof(ElfAddr));
 
     switch (type) {
     case R_AARCH64_NONE:
@@ -612,12 +862,7 @@ void Linker::processRelocation(ElfImage* /*image*/, uint32_t sym_idx, uint32_t t
 
     case R_AARCH64_IRELATIVE: {
         auto resolver = load_bias + (is_rela ? addend : *target);
-
-        struct IfuncArg { unsigned long size, hwcap, hwcap2; };
-        IfuncArg arg{sizeof(IfuncArg), getauxval(AT_HWCAP), getauxval(AT_HWCAP2)};
-        using Resolver = ElfAddr(*)(uint64_t, IfuncArg*);
-
-        *target = reinterpret_cast<Resolver>(resolver)(arg.hwcap | (1ULL << 62), &arg);
+        *target = image->resolveIfunc(resolver);
         break;
     }
 
@@ -639,33 +884,24 @@ void Linker::processRelocation(ElfImage* /*image*/, uint32_t sym_idx, uint32_t t
             LOGE("Undefined symbol: %s", sym_name);
             return;
         }
+        if (sym.image != image && (type == R_AARCH64_TLS_DTPMOD || type == R_AARCH64_TLS_TPREL ||
+                                   type == R_AARCH64_TLSDESC)) {
+            tls_providers_.push_back({image, sym.image});
+        }
 
         switch (type) {
         case R_AARCH64_GLOB_DAT:
         case R_AARCH64_JUMP_SLOT:
-            // Hook dl_iterate_phdr 和 dladdr（仅对非 TLS 类型）
-            if (strcmp(sym_name, "dl_iterate_phdr") == 0) {
-                *target = reinterpret_cast<ElfAddr>(&BacktraceManager::customDlIteratePhdr);
-                return;
-            }
-            if (strcmp(sym_name, "dladdr") == 0) {
-                *target = reinterpret_cast<ElfAddr>(&BacktraceManager::customDladdr);
-                return;
-            }
+            // 替换表中的符号（dl_iterate_phdr、dladdr 等）已在解析时生效
             *target = reinterpret_cast<ElfAddr>(sym.address);
+            import_slots_.push_back({sym_name, image, sym.image, target, 0});
             break;
-        case R_AARCH64_ABS64:
-            // Hook dl_iterate_phdr 和 dladdr（仅对非 TLS 类型）
-            if (strcmp(sym_name, "dl_iterate_phdr") == 0) {
-                *target = reinterpret_cast<ElfAddr>(&BacktraceManager::customDlIteratePhdr);
-                return;
-            }
-            if (strcmp(sym_name, "dladdr") == 0) {
-                *target = reinterpret_cast<ElfAddr>(&BacktraceManager::customDladdr);
-                return;
-            }
-            *target = reinterpret_cast<ElfAddr>(sym.address) + (is_rela ? addend : *target);
+        case R_AARCH64_ABS64: {
+            ElfAddr abs_addend = is_rela ? addend : *target;
+            *target = reinterpret_cast<ElfAddr>(sym.address) + abs_addend;
+            import_slots_.push_back({sym_name, image, sym.image, target, abs_addend});
             break;
+        }
         case R_AARCH64_TLS_DTPMOD:
             // TLS 重定位需要有效的 image
             if (!sym.image) {
@@ -706,7 +942,7 @@ void Linker::processRelocation(ElfImage* /*image*/, uint32_t sym_idx, uint32_t t
                 sym.image, &dynsym[sym_idx], addend);
             target[0] = reinterpret_cast<ElfAddr>(&dynamic_tls_resolver);
             target[1] = reinterpret_cast<ElfAddr>(ti);
-            tls_indices_.push_back(ti);
+            tls_indices_.push_back({image, ti});
             break;
         }
         }
@@ -809,6 +1045,7 @@ void Linker::processRelocations(ElfImage* image) {
             
             if ((entry & 1) == 0) {
                 auto* target = reinterpret_cast<ElfAddr*>(load_bias + entry);
+                noteTextWrite(reinterpret_cast<uintptr_t>(target), sizeof(ElfAddr));
                 *target += load_bias;
                 base_offset = entry + sizeof(ElfAddr);
             } else {
@@ -817,6 +1054,7 @@ void Linker::processRelocations(ElfImage* image) {
                     if (bitmap & 1) {
                         auto* target = reinterpret_cast<ElfAddr*>(
                             load_bias + base_offset + bit * sizeof(ElfAddr));
+                        noteTextWrite(reinterpret_cast<uintptr_t>(target), sizeof(ElfAddr));
                         *target += load_bias;
                     }
                 }
@@ -932,6 +1170,306 @@ void Linker::processRelocations(ElfImage* image) {
     }
 }
 
+void Linker::beginTextTracking(ElfImage* image) {
+    text_ranges_.clear();
+
+    auto* header = image->header();
+    auto* phdr = reinterpret_cast<ElfPhdr*>(
+        reinterpret_cast<uintptr_t>(header) + header->e_phoff);
+
+    for (int i = 0; i < header->e_phnum; i++) {
+        if (phdr[i].p_type != PT_LOAD || !(phdr[i].p_flags & PF_X)) continue;
+
+        uintptr_t seg_start = reinterpret_cast<uintptr_t>(image->base()) +
+                              phdr[i].p_vaddr - image->bias();
+        text_ranges_.push_back({seg_start, seg_start + phdr[i].p_memsz, UINTPTR_MAX, 0});
+    }
+}
+
+void Linker::noteTextWrite(uintptr_t addr, size_t size) {
+    for (auto& range : text_ranges_) {
+        if (addr + size <= range.start || addr >= range.end) continue;
+        if (addr < range.dirty_lo) range.dirty_lo = addr;
+        if (addr + size > range.dirty_hi) range.dirty_hi = addr + size;
+    }
+}
+
+void Linker::endTextTracking(ElfImage* image) {
+    std::vector<TextWriteRange> written;
+    for (auto& range : text_ranges_) {
+        if (range.dirty_lo < range.dirty_hi) written.push_back(range);
+    }
+    text_ranges_.clear();
+
+    if (!written.empty()) {
+        LOGD("Text relocations in %s, icache flush required", image->path().c_str());
+        text_writes_[image] = std::move(written);
+    }
+}
+
+void Linker::relocateImage(ElfImage* image) {
+    beginTextTracking(image);
+    processRelocations(image);
+    endTextTracking(image);
+}
+
+// 只读的可加载段临时改为可写，重定位后由 restoreProtections 恢复
+static void makeWritable(ElfImage* img) {
+    auto* header = img->header();
+    auto* phdr = reinterpret_cast<ElfPhdr*>(
+        reinterpret_cast<uintptr_t>(header) + header->e_phoff);
+    
+    for (int i = 0; i < header->e_phnum; i++) {
+        if (phdr[i].p_type != PT_LOAD) continue;
+        if (phdr[i].p_flags & PF_W) continue;
+        
+        auto start = pageStart(reinterpret_cast<uintptr_t>(img->base()) + 
+                              phdr[i].p_vaddr - img->bias());
+        auto len = pageEnd(phdr[i].p_vaddr + phdr[i].p_memsz) - pageStart(phdr[i].p_vaddr);
+        
+        int prot = PROT_READ | PROT_WRITE;
+        if (phdr[i].p_flags & PF_X) prot |= PROT_EXEC;
+        
+        mprotect(reinterpret_cast<void*>(start), len, prot);
+    }
+}
+
+// addr 所在页的段保护位（覆盖该页的全部 PT_LOAD 取并集）
+static int pageProtection(ElfImage* image, uintptr_t addr) {
+    auto* header = image->header();
+    auto* phdr = reinterpret_cast<ElfPhdr*>(
+        reinterpret_cast<uintptr_t>(header) + header->e_phoff);
+
+    uintptr_t page = pageStart(addr);
+    int prot = 0;
+    for (int i = 0; i < header->e_phnum; i++) {
+        if (phdr[i].p_type != PT_LOAD) continue;
+
+        uintptr_t seg_start = reinterpret_cast<uintptr_t>(image->base()) +
+                              phdr[i].p_vaddr - image->bias();
+        uintptr_t seg_end = seg_start + phdr[i].p_memsz;
+        if (page >= pageEnd(seg_end) || page + pageSize() <= pageStart(seg_start)) continue;
+
+        if (phdr[i].p_flags & PF_R) prot |= PROT_READ;
+        if (phdr[i].p_flags & PF_W) prot |= PROT_WRITE;
+        if (phdr[i].p_flags & PF_X) prot |= PROT_EXEC;
+    }
+    return prot;
+}
+
+bool Linker::writeSlots(std::vector<SlotWrite>& writes) {
+    // 按页处理：只有不可写的页（如代码段中的重定位）才临时放开写权限
+    std::sort(writes.begin(), writes.end(), [](const SlotWrite& a, const SlotWrite& b) {
+        return a.target < b.target;
+    });
+
+    size_t i = 0;
+    while (i < writes.size()) {
+        uintptr_t page = pageStart(reinterpret_cast<uintptr_t>(writes[i].target));
+        size_t end = i + 1;
+        while (end < writes.size() && pageStart(reinterpret_cast<uintptr_t>(writes[end].target)) == page) end++;
+
+        int prot = pageProtection(writes[i].image, page);
+        bool flip = !(prot & PROT_WRITE);
+        if (flip && mprotect(reinterpret_cast<void*>(page), pageSize(), prot | PROT_READ | PROT_WRITE) != 0) {
+            PLOGE("mprotect %p", reinterpret_cast<void*>(page));
+            return false;
+        }
+
+        // 每个槽位一次对齐的 8 字节原子写，并发调用方看到的要么是旧地址要么是新地址
+        for (size_t j = i; j < end; j++) {
+            __atomic_store_n(writes[j].target, writes[j].value, __ATOMIC_RELEASE);
+        }
+
+        if (flip) {
+            mprotect(reinterpret_cast<void*>(page), pageSize(), prot);
+            if (prot & PROT_EXEC) {
+                __builtin___clear_cache(reinterpret_cast<char*>(page),
+                                       reinterpret_cast<char*>(page + pageSize()));
+            }
+        }
+        i = end;
+    }
+    return true;
+}
+
+size_t Linker::rebindImport(std::string_view name, void* address, const ElfImage* image) {
+    std::lock_guard<std::mutex> lock(rebind_mutex_);
+
+    // 重定位时只顺序追加，首次重绑定时再按名字建立索引
+    if (import_index_.empty() && !import_slots_.empty()) {
+        for (size_t i = 0; i < import_slots_.size(); i++) {
+            import_index_[import_slots_[i].name].push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    auto it = import_index_.find(name);
+    if (it == import_index_.end()) return 0;
+
+    std::vector<SlotWrite> writes;
+    for (uint32_t idx : it->second) {
+        auto& slot = import_slots_[idx];
+        if (image && slot.image != image) continue;
+        writes.push_back({slot.image, slot.target, reinterpret_cast<ElfAddr>(address) + slot.addend});
+    }
+    if (!writeSlots(writes)) return 0;
+
+    LOGD("Rebound %zu slots of %.*s to %p", writes.size(),
+         static_cast<int>(name.size()), name.data(), address);
+    return writes.size();
+}
+
+bool Linker::reloadDependency(std::string_view name) {
+    LoadedDep retired;
+    if (!reloadDependency(name, retired)) return false;
+    retireDependency(retired);
+    return true;
+}
+
+bool Linker::reloadDependency(std::string_view name, LoadedDep& retired) {
+    if (!is_linked_) return false;
+    if (constructors_pending_) {
+        LOGE("Cannot reload a dependency before constructors have run");
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(rebind_mutex_);
+
+    auto it = std::find_if(deps_.begin(), deps_.end(), [&](const LoadedDep& dep) {
+        return dep.is_manual_load && dep.image && LibrarySearchPath::matches(dep.image->path(), name);
+    });
+    if (it == deps_.end()) {
+        LOGE("Not a manually loaded dependency: %.*s", static_cast<int>(name.size()), name.data());
+        return false;
+    }
+    if (it->shared) {
+        // 共享副本的绑定属于所有使用方，不能由单个链接器替换
+        LOGE("Cannot reload shared dependency: %s", it->image->path().c_str());
+        return false;
+    }
+    size_t index = it - deps_.begin();
+    std::string path = it->image->path();
+
+    // TLS 重定位（DTPMOD/TPREL/TLSDESC）固化了旧版本的模块号，不能像导入槽位一样改写
+    ElfImage* current = it->image.get();
+    for (auto& [image, provider] : tls_providers_) {
+        if (provider == current && image != current) {
+            LOGE("Cannot reload %s: %s has TLS relocations against it", path.c_str(),
+                 image->path().c_str());
+            return false;
+        }
+    }
+
+    // 1. 映射并解析新版本
+    LoadContext ctx;
+    if (!ctx.open(path)) return false;
+    LoadedDep fresh;
+    void* base = loadLibraryManually(ctx, fresh);
+    if (!base) {
+        LOGE("Failed to map new version of %s", path.c_str());
+        return false;
+    }
+    fresh.image = ElfImage::create(ctx, base);
+    fresh.dev = ctx.fileStat().st_dev;
+    fresh.ino = ctx.fileStat().st_ino;
+    ctx.close();
+    if (!fresh.image) {
+        munmap(base, fresh.map_size);
+        return false;
+    }
+    fresh.is_manual_load = true;
+
+    // 不为新版本加载依赖：它新增的 DT_NEEDED 必须已在作用域中，否则其导入无法解析
+    auto old_needed = neededLibraries(current);
+    for (auto& needed : neededLibraries(fresh.image.get())) {
+        if (std::find(old_needed.begin(), old_needed.end(), needed) != old_needed.end()) continue;
+        bool in_scope = std::any_of(deps_.begin(), deps_.end(), [&](const LoadedDep& dep) {
+            return dep.image && LibrarySearchPath::matches(dep.image->path(), needed);
+        });
+        if (!in_scope) {
+            LOGE("New version of %s needs %s, which is not loaded, keeping the old one",
+                 path.c_str(), needed.c_str());
+            fresh.image.reset();
+            munmap(base, fresh.map_size);
+            return false;
+        }
+    }
+
+    // 2. 新版本在作用域中占据旧版本的位置，保持原有优先级。
+    // 作用域改写期间 resolveSymbol 等待 scope_mutex_，之后只能看到新版本
+    std::unique_lock<std::mutex> scope_lock(scope_mutex_);
+    LoadedDep old = std::move(deps_[index]);
+    ElfImage* old_image = old.image.get();
+    deps_[index] = std::move(fresh);
+    ElfImage* new_image = deps_[index].image.get();
+    buildScopeFilter();
+    clearSymbolCache();
+
+    // 3. 其他镜像中绑定到旧版本的槽位必须都能在新作用域中解析，否则回滚
+    std::vector<size_t> incoming;
+    for (size_t i = 0; i < import_slots_.size(); i++) {
+        auto& slot = import_slots_[i];
+        if (slot.provider == old_image && slot.image != old_image) incoming.push_back(i);
+    }
+    for (size_t idx : incoming) {
+        // 必须由新版本提供：作用域中靠后的库或系统库的同名定义不能替代
+        if (findSymbolCached(import_slots_[idx].name).image != new_image) {
+            LOGE("New version of %s does not provide %s, keeping the old one",
+                 path.c_str(), import_slots_[idx].name);
+            munmap(deps_[index].map_base, deps_[index].map_size);
+            deps_[index] = std::move(old);
+            buildScopeFilter();
+            clearSymbolCache();
+            return false;
+        }
+    }
+
+    // 4. 重定位并初始化新版本
+    TlsManager::instance().registerSegment(new_image);
+    TlsManager::instance().bumpGeneration();
+    makeWritable(new_image);
+    relocateImage(new_image);
+    restoreProtections(new_image);
+    BacktraceManager::instance().registerLibrary(new_image);
+    BacktraceManager::instance().registerEhFrame(new_image);
+    scope_lock.unlock();
+    callConstructors(new_image);
+
+    // 5. 只改写指向旧版本的入站槽位
+    std::vector<SlotWrite> writes;
+    writes.reserve(incoming.size());
+    for (size_t idx : incoming) {
+        auto& slot = import_slots_[idx];
+        auto sym = findSymbolCached(slot.name);
+        writes.push_back({slot.image, slot.target, reinterpret_cast<ElfAddr>(sym.address) + slot.addend});
+        slot.provider = sym.image;
+    }
+    writeSlots(writes);
+
+    // 6. 旧版本交给调用方，确认没有读者仍在其中查找后由 retireDependency() 析构并卸载
+    retired = std::move(old);
+
+    LOGI("Reloaded %s, re-patched %zu incoming bindings", path.c_str(), writes.size());
+    return true;
+}
+
+void Linker::retireDependency(LoadedDep& retired) {
+    ElfImage* old_image = retired.image.get();
+    if (!old_image) return;
+    std::lock_guard<std::mutex> lock(rebind_mutex_);
+
+    BacktraceManager::instance().unregisterEhFrame(old_image);
+    BacktraceManager::instance().unregisterLibrary(old_image);
+    callDestructors(old_image);
+    TlsManager::instance().unregisterSegment(old_image);
+    import_slots_.erase(std::remove_if(import_slots_.begin(), import_slots_.end(),
+                                       [&](const ImportSlot& slot) { return slot.image == old_image; }),
+                        import_slots_.end());
+    import_index_.clear();
+    retired.image.reset();
+    munmap(retired.map_base, retired.map_size);
+    retired = {};
+}
+
 void Linker::restoreProtections(ElfImage* image) {
     auto* header = image->header();
     auto* phdr = reinterpret_cast<ElfPhdr*>(
@@ -987,19 +1525,35 @@ void Linker::restoreProtections(ElfImage* image) {
         }
     }
 
-    // 逐页恢复保护
-    for (size_t i = 0; i < num_pages; i++) {
+    // 合并相邻同保护页，每段连续区间只调用一次 mprotect
+    auto dirty = text_writes_.find(image);
+    size_t i = 0;
+    while (i < num_pages) {
         int prot = page_prots[i];
-        if (prot == 0) continue;
-
-        uintptr_t page_addr = start_page + i * pg_size;
-        mprotect(reinterpret_cast<void*>(page_addr), pg_size, prot);
-
-        if (prot & PROT_EXEC) {
-            __builtin___clear_cache(reinterpret_cast<char*>(page_addr),
-                                   reinterpret_cast<char*>(page_addr + pg_size));
+        size_t run_end = i + 1;
+        while (run_end < num_pages && page_prots[run_end] == prot) run_end++;
+
+        if (prot != 0) {
+            uintptr_t run_start = start_page + i * pg_size;
+            uintptr_t run_stop = start_page + run_end * pg_size;
+            mprotect(reinterpret_cast<void*>(run_start), run_stop - run_start, prot);
+
+            // 仅对被重定位写入过的可执行区间刷新指令缓存
+            if ((prot & PROT_EXEC) && dirty != text_writes_.end()) {
+                for (auto& range : dirty->second) {
+                    uintptr_t lo = std::max(range.dirty_lo, run_start);
+                    uintptr_t hi = std::min(range.dirty_hi, run_stop);
+                    if (lo < hi) {
+                        __builtin___clear_cache(reinterpret_cast<char*>(lo),
+                                               reinterpret_cast<char*>(hi));
+                    }
+                }
+            }
         }
+        i = run_end;
     }
+
+    if (dirty != text_writes_.end()) text_writes_.erase(dirty);
 }
 
 void Linker::callConstructors(ElfImage* image) {
@@ -1040,77 +1594,285 @@ void Linker::callDestructors(ElfImage* image) {
     }
 }
 
-bool Linker::link() {
-    // 1. 加载依赖
-    if (!loadDependencies()) {
+void Linker::constructShared(SharedDependency* dep) {
+    // 多个链接器可能同时需要同一个推迟构造的副本：只由第一个执行，其余等待其完成
+    std::lock_guard<std::mutex> lock(dep->init_mutex);
+    if (dep->constructed) return;
+    callConstructors(dep->image.get());
+    dep->constructed = true;
+}
+
+void Linker::publishSharedDependencies() {
+    if (!share_deps_ || !overrides_.empty()) return;
+
+    // 候选：新映射的依赖（命名空间中显式加载的库不登记）
+    std::unordered_map<ElfImage*, LoadedDep*> by_image;
+    std::unordered_set<ElfImage*> candidates;
+    for (auto& dep : deps_) {
+        if (!dep.image) continue;
+        by_image[dep.image.get()] = &dep;
+        if (dep.is_manual_load && !dep.shared && !dep.root) candidates.insert(dep.image.get());
+    }
+    if (candidates.empty()) return;
+
+    // 共享副本的绑定只能指向系统库、已共享的依赖或其他候选：主库和私有依赖随本链接器卸载。
+    // TLS 模块号随注册方注销，TLS 引用还不能指向系统库
+    struct Edge {
+        ElfImage* from;
+        ElfImage* to;
+        bool tls;
+    };
+    std::vector<Edge> edges;
+    for (auto& slot : import_slots_) {
+        if (slot.provider && slot.provider != slot.image && candidates.count(slot.image)) {
+            edges.push_back({slot.image, slot.provider, false});
+        }
+    }
+    for (auto& [image, provider] : tls_providers_) {
+        if (candidates.count(image)) edges.push_back({image, provider, true});
+    }
+
+    auto acceptable = [&](const Edge& edge) {
+        auto it = by_image.find(edge.to);
+        if (it == by_image.end()) return false;
+        auto* dep = it->second;
+        if (!dep->is_manual_load) return !edge.tls;
+        return dep->shared != nullptr || candidates.count(edge.to) > 0;
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto& edge : edges) {
+            if (candidates.count(edge.from) && !acceptable(edge)) {
+                candidates.erase(edge.from);
+                changed = true;
+            }
+        }
+    }
+    if (candidates.empty()) return;
+
+    std::vector<std::unique_ptr<SharedDependency>> batch;
+    std::unordered_map<ElfImage*, SharedDependency*> created;
+    for (auto& dep : deps_) {
+        if (!candidates.count(dep.image.get())) continue;
+        auto entry = std::make_unique<SharedDependency>();
+        entry->image = dep.image;
+        entry->map_base = dep.map_base;
+        entry->map_size = dep.map_size;
+        entry->dev = dep.dev;
+        entry->ino = dep.ino;
+        entry->build_id = std::string(dep.image->buildId());
+        entry->constructed = !constructors_pending_;
+        created[dep.image.get()] = entry.get();
+        batch.push_back(std::move(entry));
+    }
+
+    for (auto& edge : edges) {
+        auto from = created.find(edge.from);
+        if (from == created.end() || edge.to == edge.from) continue;
+        auto* provider = by_image[edge.to]->shared;
+        if (!provider) {
+            auto to = created.find(edge.to);
+            if (to == created.end()) continue;      // 系统库
+            provider = to->second;
+        }
+        auto& providers = from->second->providers;
+        if (std::find(providers.begin(), providers.end(), provider) == providers.end()) {
+            providers.push_back(provider);
+        }
+    }
+    for (auto& [image, ti] : tls_indices_) {
+        auto it = created.find(image);
+        if (it != created.end()) it->second->tls_indices.push_back(ti);
+    }
+
+    DependencyRegistry::instance().publish(batch);
+
+    // 未登记的项留在 batch 中，本链接器继续私有持有
+    std::unordered_set<ElfImage*> published;
+    for (auto& [image, entry] : created) {
+        bool rejected = std::any_of(batch.begin(), batch.end(),
+                                    [&](const auto& e) { return e.get() == entry; });
+        if (rejected) continue;
+        by_image[image]->shared = entry;
+        published.insert(image);
+    }
+    if (published.empty()) return;
+
+    // 已登记镜像的 TLS 描述符和导入槽位归注册表所有，本链接器不再释放或重绑定
+    tls_indices_.erase(std::remove_if(tls_indices_.begin(), tls_indices_.end(),
+                                      [&](const auto& entry) { return published.count(entry.first) > 0; }),
+                       tls_indices_.end());
+    import_slots_.erase(std::remove_if(import_slots_.begin(), import_slots_.end(),
+                                       [&](const ImportSlot& slot) { return published.count(slot.image) > 0; }),
+                        import_slots_.end());
+    import_index_.clear();
+
+    LOGI("Shared %zu of %zu newly mapped dependencies", published.size(), created.size());
+}
+
+void Linker::releaseSharedDependencies(size_t first_dep) {
+    std::vector<std::unique_ptr<SharedDependency>> retired;
+    for (size_t i = deps_.size(); i > first_dep; i--) {
+        auto& dep = deps_[i - 1];
+        if (dep.shared) {
+            DependencyRegistry::instance().release(dep.shared, retired);
+            dep.shared = nullptr;
+        }
+    }
+
+    // 最后一个引用方负责析构和卸载（retired 已按引用方在前排序）
+    for (auto& dep : retired) {
+        auto* image = dep->image.get();
+        LOGD("Tearing down shared %s", image->path().c_str());
+        BacktraceManager::instance().unregisterEhFrame(image);
+        BacktraceManager::instance().unregisterLibrary(image);
+        if (dep->constructed) callDestructors(image);
+        TlsManager::instance().unregisterSegment(image);
+        for (auto* ti : dep->tls_indices) {
+            delete ti;
+        }
+        munmap(dep->map_base, dep->map_size);
+    }
+}
+
+bool Linker::link(std::vector<LoadedDep> roots) {
+    // 1. 加载依赖（同批加入的库排在主库之后，先于各自的依赖）
+    std::vector<ElfImage*> needed_from{main_image_.get()};
+    for (auto& lib : roots) {
+        lib.root = true;
+        needed_from.push_back(lib.image.get());
+        deps_.push_back(std::move(lib));
+    }
+    if (!loadDependencies(needed_from)) {
         LOGE("Failed to load dependencies");
         return false;
     }
     
-    // 2. 注册 TLS
-    TlsManager::instance().registerSegment(main_image_.get());
-    for (auto& dep : deps_) {
-        TlsManager::instance().registerSegment(dep.image.get());
+    dropUnsafeOverrides();
+    linkImages(0, true);
+    is_linked_ = true;
+    
+    // 新映射且只引用共享库或系统库的依赖登记到进程级注册表
+    publishSharedDependencies();
+    return true;
+}
+
+bool Linker::addLibraries(std::vector<LoadedDep> libs) {
+    if (!is_linked_ || libs.empty()) return false;
+    
+    size_t first = deps_.size();
+    std::vector<ElfImage*> needed_from;
+    for (auto& lib : libs) {
+        lib.root = true;
+        needed_from.push_back(lib.image.get());
+        deps_.push_back(std::move(lib));
     }
-    TlsManager::instance().bumpGeneration();
     
-    // 3. 设置内存可写
-    auto makeWritable = [](ElfImage* img) {
-        auto* header = img->header();
-        auto* phdr = reinterpret_cast<ElfPhdr*>(
-            reinterpret_cast<uintptr_t>(header) + header->e_phoff);
-        
-        for (int i = 0; i < header->e_phnum; i++) {
-            if (phdr[i].p_type != PT_LOAD) continue;
-            if (phdr[i].p_flags & PF_W) continue;
-            
-            auto start = pageStart(reinterpret_cast<uintptr_t>(img->base()) + 
-                                  phdr[i].p_vaddr - img->bias());
-            auto len = pageEnd(phdr[i].p_vaddr + phdr[i].p_memsz) - pageStart(phdr[i].p_vaddr);
-            
-            int prot = PROT_READ | PROT_WRITE;
-            if (phdr[i].p_flags & PF_X) prot |= PROT_EXEC;
-            
-            mprotect(reinterpret_cast<void*>(start), len, prot);
+    // 缓存中"未找到"的结果可能由新库定义；已找到的结果不变（新库排在作用域末尾）
+    clearSymbolCache();
+    
+    if (!loadDependencies(needed_from)) {
+        LOGE("Failed to load dependencies of %zu added libraries", libs.size());
+        discardDependencies(first);
+        buildScopeFilter();
+        return false;
+    }
+    
+    linkImages(first, false);
+    publishSharedDependencies();
+    return true;
+}
+
+void Linker::discardDependencies(size_t first_dep) {
+    // 尚未注册和重定位的依赖：只需归还句柄、私有映射和共享副本的引用
+    // （共享副本的映射由注册表持有，其他链接器可能仍在使用）
+    for (size_t i = first_dep; i < deps_.size(); i++) {
+        auto& dep = deps_[i];
+        if (dep.handle) {
+            system_scope_.erase(std::remove(system_scope_.begin(), system_scope_.end(), dep.handle),
+                                system_scope_.end());
+            dlclose(dep.handle);
         }
-    };
+        if (dep.is_manual_load && !dep.shared && dep.map_size > 0) munmap(dep.map_base, dep.map_size);
+    }
+    releaseSharedDependencies(first_dep);
+    deps_.erase(deps_.begin() + first_dep, deps_.end());
+}
+
+void Linker::linkImages(size_t first_dep, bool with_main) {
+    // 整批预解析导入符号
+    buildScopeFilter();
+    preresolveImports(first_dep, with_main);
     
-    makeWritable(main_image_.get());
-    for (auto& dep : deps_) {
-        if (dep.is_manual_load) makeWritable(dep.image.get());
+    // 本批需要重定位和初始化的镜像（主库在前）；复用的共享副本已完成这些步骤
+    std::vector<ElfImage*> images;
+    if (with_main) images.push_back(main_image_.get());
+    for (size_t i = first_dep; i < deps_.size(); i++) {
+        if (deps_[i].is_manual_load && !deps_[i].shared) images.push_back(deps_[i].image.get());
     }
     
-    // 4. 处理重定位
-    processRelocations(main_image_.get());
-    for (auto& dep : deps_) {
-        if (dep.is_manual_load) processRelocations(dep.image.get());
+    // 2. 注册 TLS（系统库也登记模块号）
+    if (with_main) TlsManager::instance().registerSegment(main_image_.get());
+    for (size_t i = first_dep; i < deps_.size(); i++) {
+        if (!deps_[i].shared) TlsManager::instance().registerSegment(deps_[i].image.get());
     }
+    TlsManager::instance().bumpGeneration();
+    
+    // 3. 设置内存可写
+    for (auto* image : images) makeWritable(image);
+    
+    // 4. 处理重定位
+    for (auto* image : images) relocateImage(image);
     
     // 5. 恢复内存保护
-    restoreProtections(main_image_.get());
-    for (auto& dep : deps_) {
-        if (dep.is_manual_load) restoreProtections(dep.image.get());
-    }
+    for (auto* image : images) restoreProtections(image);
     
     // 6. 注册回溯支持
-    BacktraceManager::instance().registerLibrary(main_image_.get());
-    BacktraceManager::instance().registerEhFrame(main_image_.get());
+    for (auto* image : images) {
+        BacktraceManager::instance().registerLibrary(image);
+        BacktraceManager::instance().registerEhFrame(image);
+    }
     
-    for (auto& dep : deps_) {
-        if (dep.is_manual_load) {
-            BacktraceManager::instance().registerLibrary(dep.image.get());
-            BacktraceManager::instance().registerEhFrame(dep.image.get());
+    // 7. 调用构造函数；推迟时只记录本批起点，之前推迟的批次一并留给 runConstructors()
+    if (defer_constructors_) {
+        if (!constructors_pending_) {
+            constructors_pending_ = true;
+            pending_dep_ = first_dep;
+            pending_main_ = with_main;
         }
+        return;
     }
-    
-    // 7. 调用构造函数（先依赖后主库）
-    for (auto& dep : deps_) {
-        if (dep.is_manual_load) callConstructors(dep.image.get());
+    if (constructors_pending_) {
+        runConstructors();
+        return;
+    }
+    construct(first_dep, with_main);
+}
+
+void Linker::construct(size_t first_dep, bool with_main) {
+    // 先依赖，再按加载顺序调用显式加载的库，最后主库（主库作为首个显式加载的库时排在它们之前）。
+    // 复用的共享副本若由推迟构造的链接器登记，在这里补做构造
+    for (size_t i = first_dep; i < deps_.size(); i++) {
+        auto& dep = deps_[i];
+        if (dep.shared) {
+            constructShared(dep.shared);
+        } else if (dep.is_manual_load && !dep.root) {
+            callConstructors(dep.image.get());
+        }
     }
-    callConstructors(main_image_.get());
+    if (with_main && main_is_root_) callConstructors(main_image_.get());
+    for (size_t i = first_dep; i < deps_.size(); i++) {
+        if (deps_[i].root && !deps_[i].shared) callConstructors(deps_[i].image.get());
+    }
+    if (with_main && !main_is_root_) callConstructors(main_image_.get());
+}
+
+void Linker::runConstructors() {
+    if (!is_linked_ || !constructors_pending_) return;
     
-    is_linked_ = true;
-    return true;
+    // 推迟期间登记的共享副本标记为未构造，与私有依赖按同一顺序经 constructShared 构造
+    constructors_pending_ = false;
+    construct(pending_dep_, pending_main_);
 }
 
 } // namespace soloader
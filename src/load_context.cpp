@@ -0,0 +1,145 @@
+// Modern C++17 SO Loader - Load Context Implementation (arm64 only)
+
+#include "load_context.hpp"
+#include "log.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+
+namespace soloader {
+
+LoadContext::~LoadContext() {
+    close();
+}
+
+LoadContext::LoadContext(LoadContext&& other) noexcept {
+    *this = std::move(other);
+}
+
+LoadContext& LoadContext::operator=(LoadContext&& other) noexcept {
+    if (this != &other) {
+        close();
+
+        path_ = std::move(other.path_);
+        fd_ = other.fd_;
+        st_ = other.st_;
+        image_ = other.image_;
+
+        other.fd_ = -1;
+        other.image_ = nullptr;
+    }
+    return *this;
+}
+
+bool LoadContext::open(std::string_view path) {
+    close();
+    path_ = path;
+
+    fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        PLOGE("open %s", path_.c_str());
+        return false;
+    }
+
+    if (fstat(fd_, &st_) != 0) {
+        PLOGE("fstat %s", path_.c_str());
+        close();
+        return false;
+    }
+
+    return checkFile();
+}
+
+bool LoadContext::adoptFd(std::string_view path, int fd, const struct stat& st) {
+    close();
+    path_ = path;
+    fd_ = fd;
+    st_ = st;
+    return checkFile();
+}
+
+bool LoadContext::checkFile() {
+    if (!S_ISREG(st_.st_mode)) {
+        LOGE("Not a regular file: %s", path_.c_str());
+        close();
+        return false;
+    }
+
+    if (fileSize() <= sizeof(ElfEhdr)) {
+        LOGE("File too small: %s", path_.c_str());
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void LoadContext::setImage(void* image) {
+    if (image_) free(image_);
+    image_ = image;
+}
+
+void LoadContext::adviseWillNeed() const {
+    if (fd_ < 0 || image_) return;
+    int err = posix_fadvise(fd_, 0, 0, POSIX_FADV_WILLNEED);
+    if (err != 0) {
+        LOGW("posix_fadvise %s: %s", path_.c_str(), strerror(err));
+    }
+}
+
+bool LoadContext::readImage() {
+    if (image_) return true;
+    if (fd_ < 0) return false;
+
+    size_t size = fileSize();
+    image_ = malloc(size);
+    if (!image_) {
+        LOGE("Failed to allocate %zu bytes", size);
+        return false;
+    }
+
+    size_t total = 0;
+    while (total < size) {
+        ssize_t n = pread(fd_, static_cast<char*>(image_) + total, size - total, total);
+        if (n <= 0) {
+            PLOGE("read %s", path_.c_str());
+            free(image_);
+            image_ = nullptr;
+            return false;
+        }
+        total += n;
+    }
+
+    return true;
+}
+
+void LoadContext::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (image_) {
+        free(image_);
+        image_ = nullptr;
+    }
+}
+
+void* LoadContext::releaseImage() {
+    void* image = image_;
+    image_ = nullptr;
+    return image;
+}
+
+const ElfPhdr* LoadContext::programHeaders() const {
+    auto* eh = header();
+    if (!eh || !eh->e_phoff || !eh->e_phnum) return nullptr;
+    if (eh->e_phoff + eh->e_phnum * sizeof(ElfPhdr) > fileSize()) {
+        LOGE("Program header table out of bounds: %s", path_.c_str());
+        return nullptr;
+    }
+    return reinterpret_cast<const ElfPhdr*>(
+        static_cast<const uint8_t*>(image_) + eh->e_phoff);
+}
+
+} // namespace soloader
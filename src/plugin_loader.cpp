@@ -0,0 +1,131 @@
+// Modern C++17 SO Loader - Parallel Plugin Loader Implementation (arm64 only)
+
+#include "plugin_loader.hpp"
+#include "search_path.hpp"
+#include "log.hpp"
+#include <dirent.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace soloader {
+
+using Clock = std::chrono::steady_clock;
+
+static std::chrono::microseconds elapsedSince(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+}
+
+static bool hasSoSuffix(std::string_view name) {
+    return name.size() > 3 && name.substr(name.size() - 3) == ".so";
+}
+
+PluginLoader::~PluginLoader() {
+    unloadAll();
+}
+
+std::vector<std::string> PluginLoader::listDirectory(std::string_view dir) {
+    std::string base(dir);
+    if (base.empty() || base.back() != '/') base.push_back('/');
+    
+    std::vector<std::string> paths;
+    DIR* d = opendir(base.c_str());
+    if (!d) {
+        LOGE("Cannot list plugin directory: %s", base.c_str());
+        return paths;
+    }
+    while (auto* ent = readdir(d)) {
+        if (ent->d_type == DT_DIR || !hasSoSuffix(ent->d_name)) continue;
+        paths.push_back(base + ent->d_name);
+    }
+    closedir(d);
+    
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+size_t PluginLoader::load(const std::vector<std::string>& paths, const PluginLoadOptions& options) {
+    auto batch_start = Clock::now();
+    
+    // 之前失败的结果不保留，允许重试
+    results_.erase(std::remove_if(results_.begin(), results_.end(),
+                                  [](const PluginResult& r) { return !r.ok(); }),
+                   results_.end());
+    
+    // 本批结果按输入顺序排在已有结果之后，已加载的路径跳过
+    size_t first = results_.size();
+    for (auto& path : paths) {
+        bool duplicate = std::any_of(results_.begin(), results_.end(),
+                                     [&](const PluginResult& r) { return r.path == path; });
+        if (duplicate) {
+            LOGW("Plugin already loaded: %s", path.c_str());
+            continue;
+        }
+        PluginResult result;
+        result.path = path;
+        results_.push_back(std::move(result));
+    }
+    size_t count = results_.size() - first;
+    if (count == 0) return 0;
+    
+    // 1. 工作线程按序领取库，完成映射到重定位（构造函数推迟）；调用线程同样参与
+    std::atomic<size_t> next{first};
+    auto worker = [&] {
+        while (true) {
+            size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= results_.size()) break;
+            auto& result = results_[i];
+            auto start = Clock::now();
+            auto loader = std::make_unique<SoLoader>();
+            loader->setDeferConstructors(true);
+            loader->setShareDependencies(options.share_dependencies);
+            loader->setArenaEnabled(options.arena);
+            if (loader->load(result.path)) result.loader = std::move(loader);
+            result.load_time = elapsedSince(start);
+        }
+    };
+    
+    size_t threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    threads = std::clamp<size_t>(threads, 1, count);
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool) thread.join();
+    
+    // 2. 按输入顺序执行构造函数（依赖在前，各库主库最后）
+    size_t loaded = 0;
+    for (size_t i = first; i < results_.size(); i++) {
+        auto& result = results_[i];
+        if (!result.ok()) {
+            LOGE("Failed to load plugin: %s", result.path.c_str());
+            continue;
+        }
+        auto start = Clock::now();
+        result.loader->runConstructors();
+        result.init_time = elapsedSince(start);
+        loaded++;
+    }
+    
+    last_batch_time_ = elapsedSince(batch_start);
+    LOGI("Loaded %zu of %zu plugins on %zu threads in %lld us", loaded, count, threads,
+         static_cast<long long>(last_batch_time_.count()));
+    return loaded;
+}
+
+SoLoader* PluginLoader::find(std::string_view name) const {
+    for (auto& result : results_) {
+        if (result.ok() && LibrarySearchPath::matches(result.path, name)) return result.loader.get();
+    }
+    return nullptr;
+}
+
+void PluginLoader::unloadAll() {
+    // 后加载的插件可能使用先加载插件登记的共享依赖，逆序卸载
+    for (auto it = results_.rbegin(); it != results_.rend(); ++it) {
+        it->loader.reset();
+    }
+    results_.clear();
+}
+
+} // namespace soloader
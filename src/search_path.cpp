@@ -0,0 +1,197 @@
+// Modern C++17 SO Loader - Library Search Path Implementation (arm64 only)
+
+#include "search_path.hpp"
+#include "log.hpp"
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cstdlib>
+
+namespace soloader {
+
+// 默认搜索目录（按优先级排序）
+static const char* const kDefaultSearchPaths[] = {
+#ifdef __ANDROID__
+    // APEX 运行时库（Android 10+）
+    "/apex/com.android.runtime/lib64/bionic/",
+    "/apex/com.android.runtime/lib64/",
+    "/apex/com.android.art/lib64/",
+    // 系统库
+    "/system/lib64/",
+    "/system/lib64/vndk/",
+    "/system/lib64/vndk-sp/",
+    // 供应商库
+    "/vendor/lib64/",
+    "/vendor/lib64/vndk/",
+    "/vendor/lib64/vndk-sp/",
+    // ODM 库
+    "/odm/lib64/",
+    // 产品库
+    "/product/lib64/",
+    // 系统扩展库
+    "/system_ext/lib64/",
+#else
+    // 主机 Linux（用于离线测试与基准）
+    "/lib/aarch64-linux-gnu/",
+    "/usr/lib/aarch64-linux-gnu/",
+    "/lib64/",
+    "/usr/lib64/",
+    "/lib/",
+    "/usr/lib/",
+#endif
+};
+
+static std::string normalizeDir(std::string_view dir) {
+    std::string out(dir);
+    if (out.empty() || out.back() != '/') out.push_back('/');
+    return out;
+}
+
+static bool sameTime(const struct timespec& a, const struct timespec& b) {
+    return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+}
+
+LibrarySearchPath& LibrarySearchPath::instance() {
+    static LibrarySearchPath inst;
+    return inst;
+}
+
+LibrarySearchPath::LibrarySearchPath() {
+    for (auto* dir : kDefaultSearchPaths) {
+        base_paths_.emplace_back(dir);
+    }
+    if (const char* env = getenv("LD_LIBRARY_PATH")) {
+        setLibraryPath(env);
+    } else {
+        rebuildLocked();
+    }
+}
+
+void LibrarySearchPath::setSearchPaths(const std::vector<std::string>& dirs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    base_paths_.clear();
+    for (auto& dir : dirs) {
+        if (!dir.empty()) base_paths_.push_back(normalizeDir(dir));
+    }
+    rebuildLocked();
+}
+
+void LibrarySearchPath::setLibraryPath(std::string_view colon_list) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    override_paths_.clear();
+    while (!colon_list.empty()) {
+        size_t pos = colon_list.find(':');
+        auto dir = colon_list.substr(0, pos);
+        if (!dir.empty()) override_paths_.push_back(normalizeDir(dir));
+        if (pos == std::string_view::npos) break;
+        colon_list.remove_prefix(pos + 1);
+    }
+    rebuildLocked();
+}
+
+std::vector<std::string> LibrarySearchPath::searchPaths() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> out;
+    for (auto& dir : dirs_) out.push_back(dir.path);
+    return out;
+}
+
+void LibrarySearchPath::rebuildLocked() {
+    // 保留已枚举过的目录，避免重复扫描
+    std::vector<Directory> old = std::move(dirs_);
+    dirs_.clear();
+
+    auto add = [&](const std::string& path) {
+        for (auto& dir : dirs_) {
+            if (dir.path == path) return;
+        }
+        for (auto& dir : old) {
+            if (dir.path == path) {
+                dirs_.push_back(std::move(dir));
+                return;
+            }
+        }
+        Directory dir;
+        dir.path = path;
+        dirs_.push_back(std::move(dir));
+    };
+
+    for (auto& path : override_paths_) add(path);
+    for (auto& path : base_paths_) add(path);
+}
+
+void LibrarySearchPath::scanLocked(Directory& dir) {
+    dir.scanned = true;
+    dir.listable = false;
+    dir.entries.clear();
+
+    struct stat st;
+    if (stat(dir.path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        // 不存在的目录视为空目录，mtime 置零以便出现后重新枚举
+        dir.listable = true;
+        dir.mtime = {};
+        return;
+    }
+    dir.mtime = st.st_mtim;
+
+    DIR* d = opendir(dir.path.c_str());
+    if (!d) {
+        LOGD("Cannot list %s, falling back to access()", dir.path.c_str());
+        return;
+    }
+
+    while (auto* ent = readdir(d)) {
+        if (ent->d_type == DT_DIR) continue;
+        dir.entries.emplace(ent->d_name);
+    }
+    closedir(d);
+    dir.listable = true;
+
+    LOGD("Indexed %zu entries in %s", dir.entries.size(), dir.path.c_str());
+}
+
+void LibrarySearchPath::refresh() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& dir : dirs_) {
+        if (!dir.scanned) {
+            scanLocked(dir);
+            continue;
+        }
+
+        struct stat st;
+        struct timespec mtime{};
+        if (stat(dir.path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) mtime = st.st_mtim;
+        if (!sameTime(mtime, dir.mtime)) scanLocked(dir);
+    }
+}
+
+bool LibrarySearchPath::matches(std::string_view path, std::string_view name) {
+    if (path == name) return true;
+    size_t slash = path.rfind('/');
+    return slash != std::string_view::npos && path.substr(slash + 1) == name;
+}
+
+bool LibrarySearchPath::find(std::string_view name, std::string& out) {
+    if (!name.empty() && name[0] == '/') {
+        out = name;
+        return access(out.c_str(), F_OK) == 0;
+    }
+
+    std::string key(name);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& dir : dirs_) {
+        if (!dir.scanned) scanLocked(dir);
+
+        if (dir.listable) {
+            if (dir.entries.count(key) == 0) continue;
+            out = dir.path + key;
+            return true;
+        }
+
+        out = dir.path + key;
+        if (access(out.c_str(), F_OK) == 0) return true;
+    }
+    return false;
+}
+
+} // namespace soloader
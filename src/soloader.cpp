@@ -1,10 +1,12 @@
 // Modern C++17 SO Loader - Main Implementation (arm64 only)
 
 #include "soloader.hpp"
+#include "load_context.hpp"
 #include "log.hpp"
 #include <sys/mman.h>
-#include <sys/stat.h>
-#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <thread>
 
 namespace soloader {
 
@@ -12,114 +14,304 @@ SoLoader::~SoLoader() {
     if (isLoaded()) {
         unload();
     }
+    
+    // 仍在宽限期内的旧版本等到期后再析构
+    std::chrono::steady_clock::time_point last{};
+    {
+        std::lock_guard<std::mutex> lock(retire_mutex_);
+        for (auto& retired : retired_) last = std::max(last, retired.deadline);
+    }
+    std::this_thread::sleep_until(last);
+    collectRetired();
 }
 
-bool SoLoader::load(std::string_view lib_path) {
-    if (isLoaded()) {
-        LOGE("Already loaded a library: %s", lib_path_.c_str());
-        return false;
-    }
-    
-    // 验证文件存在且可读
+std::unique_ptr<SoLoader::Generation> SoLoader::loadGeneration(std::string_view lib_path) {
+    // 只打开一次：fstat 校验、段映射和 ELF 解析共用同一个 fd
     std::string path_str(lib_path);
-    struct stat st;
-    if (stat(path_str.c_str(), &st) != 0) {
-        LOGE("Library file not found: %s", path_str.c_str());
-        return false;
-    }
-    
-    if (!S_ISREG(st.st_mode)) {
-        LOGE("Not a regular file: %s", path_str.c_str());
-        return false;
-    }
-    
-    if (access(path_str.c_str(), R_OK) != 0) {
-        LOGE("Library file not readable: %s", path_str.c_str());
-        return false;
+    LoadContext ctx;
+    if (!ctx.open(path_str)) {
+        LOGE("Library file not accessible: %s", path_str.c_str());
+        return nullptr;
     }
     
     LOGI("Loading library: %s (size: %lld bytes)", path_str.c_str(), 
-         static_cast<long long>(st.st_size));
+         static_cast<long long>(ctx.fileSize()));
     
     // 手动加载库
     LoadedDep dep;
-    void* base = Linker::loadLibraryManually(lib_path, dep);
+    void* base = Linker::loadLibraryManually(ctx, dep);
     if (!base) {
         LOGE("Failed to map library into memory: %s", path_str.c_str());
-        return false;
+        return nullptr;
     }
     
     LOGD("Library mapped at %p, size: %zu", base, dep.map_size);
     
     // 创建 ELF 镜像
-    auto image = ElfImage::create(lib_path, base);
+    auto image = ElfImage::create(ctx, base);
+    ctx.close();
     if (!image) {
         LOGE("Failed to parse ELF image: %s", path_str.c_str());
         munmap(base, dep.map_size);
-        return false;
+        return nullptr;
     }
     
     // 初始化链接器
-    if (!linker_.init(std::move(image))) {
+    auto gen = std::make_unique<Generation>();
+    if (!gen->linker.init(std::move(image))) {
         LOGE("Failed to initialize linker for: %s", path_str.c_str());
         munmap(base, dep.map_size);
-        return false;
+        return nullptr;
     }
     
-    linker_.setMainMapSize(dep.map_size);
+    gen->linker.setMainMapSize(dep.map_size);
+    gen->linker.setShareDependencies(share_deps_);
+    gen->linker.setDeferConstructors(defer_constructors_);
+    
+    // 分配函数导入在重定位时绑定到 arena
+    if (arena_enabled_) {
+        gen->arena = PluginArena::create();
+        if (gen->arena) {
+            gen->linker.setSymbolOverrides(gen->arena->overrides());
+        } else {
+            LOGW("No arena available, %s uses the system allocator", path_str.c_str());
+        }
+    }
     
     // 执行链接
-    if (!linker_.link()) {
+    if (!gen->linker.link()) {
         LOGE("Failed to link library: %s", path_str.c_str());
-        linker_.destroy();
+        gen->linker.destroy();
+        return nullptr;
+    }
+    
+    // 作用域中的系统库自带 operator new/delete 时链接器放弃了替换，arena 不再使用
+    if (gen->arena && !gen->linker.hasSymbolOverrides()) {
+        LOGW("Arena disabled for %s, it shares operator new/delete with a system library", path_str.c_str());
+        gen->arena.reset();
+    }
+    
+    gen->path = std::move(path_str);
+    gen->image = gen->linker.mainImage();
+    
+    // 导出较多的主库构建完美哈希导出表，getSymbol 未命中缓存时一次探测
+    gen->image->buildExportIndex(export_index_threshold_);
+    
+    LOGI("Successfully loaded: %s at %p", gen->path.c_str(), gen->image->base());
+    return gen;
+}
+
+void SoLoader::destroyGeneration(std::unique_ptr<Generation> gen) {
+    gen->linker.destroy();
+    gen->symbol_caches[0].clear();
+    gen->symbol_caches[1].clear();
+    
+    // 析构函数已执行，库未释放的内存随 arena 一起回收
+    gen->arena.reset();
+}
+
+bool SoLoader::load(std::string_view lib_path) {
+    collectRetired();
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    if (isLoaded()) {
+        LOGE("Already loaded a library: %s", path().c_str());
         return false;
     }
     
-    lib_path_ = lib_path;
-    image_ = linker_.mainImage();
+    auto gen = loadGeneration(lib_path);
+    if (!gen) return false;
     
-    LOGI("Successfully loaded: %s at %p", lib_path_.c_str(), image_->base());
+    current_.store(gen.release(), std::memory_order_release);
     return true;
 }
 
+bool SoLoader::reload(std::string_view lib_path, std::chrono::milliseconds grace) {
+    {
+        std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+        
+        // 新版本的加载、链接和构造函数都在发布前完成，期间旧版本照常服务
+        auto gen = loadGeneration(lib_path);
+        if (!gen) {
+            if (current()) {
+                LOGE("Reload of %.*s failed, keeping the current version",
+                     static_cast<int>(lib_path.size()), lib_path.data());
+            }
+            return false;
+        }
+        gen->linker.runConstructors();
+        
+        std::unique_ptr<Generation> old(current_.exchange(gen.release(), std::memory_order_acq_rel));
+        if (!old) return true;
+        
+        LOGI("Published %s, retiring %s after %lld ms", current()->path.c_str(),
+             old->path.c_str(), static_cast<long long>(grace.count()));
+        
+        // 给已取得的函数指针留出宽限期，到期后在锁外回收
+        std::lock_guard<std::mutex> retire_lock(retire_mutex_);
+        retired_.push_back({std::chrono::steady_clock::now() + grace, std::move(old)});
+    }
+    
+    // 回收之前 reload 撤下且已到期的版本（宽限期为 0 时包括刚撤下的旧版本）
+    collectRetired();
+    return true;
+}
+
+size_t SoLoader::collectRetired() {
+    std::vector<std::unique_ptr<Generation>> expired;
+    size_t pending = 0;
+    {
+        std::lock_guard<std::mutex> lock(retire_mutex_);
+        auto now = std::chrono::steady_clock::now();
+        for (auto& retired : retired_) {
+            if (retired.deadline <= now) expired.push_back(std::move(retired.gen));
+        }
+        retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                      [](const RetiredGeneration& retired) { return !retired.gen; }),
+                       retired_.end());
+        pending = retired_.size();
+    }
+    if (expired.empty()) return pending;
+    
+    // 撤下前进入的读者可能仍在旧版本中查找，等它们离开后再析构和解除映射
+    EpochDomain::instance().synchronize();
+    for (auto& gen : expired) {
+        LOGI("Retiring %s", gen->path.c_str());
+        destroyGeneration(std::move(gen));
+    }
+    return pending;
+}
+
 bool SoLoader::unload() {
-    if (!isLoaded()) {
+    collectRetired();
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    std::unique_ptr<Generation> gen(current_.exchange(nullptr, std::memory_order_acq_rel));
+    if (!gen) {
         LOGW("No library loaded");
         return false;
     }
     
-    LOGI("Unloading library: %s", lib_path_.c_str());
-    
-    linker_.destroy();
+    LOGI("Unloading library: %s", gen->path.c_str());
     
-    lib_path_.clear();
-    image_ = nullptr;
+    // 已撤下：新的查找看到未加载，进行中的查找退出后才析构和解除映射
+    EpochDomain::instance().synchronize();
+    destroyGeneration(std::move(gen));
     
     LOGI("Library unloaded successfully");
     return true;
 }
 
 bool SoLoader::abandon() {
-    if (!isLoaded()) {
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    std::unique_ptr<Generation> gen(current_.exchange(nullptr, std::memory_order_acq_rel));
+    if (!gen) {
         LOGW("No library loaded");
         return false;
     }
     
-    LOGI("Abandoning library: %s (no destructors called)", lib_path_.c_str());
+    LOGI("Abandoning library: %s (no destructors called)", gen->path.c_str());
+    
+    // 映射虽保留，ElfImage 和符号缓存仍会释放
+    EpochDomain::instance().synchronize();
+    gen->linker.abandon();
+    
+    // 库的内存映射保留，其仍可能访问的 arena 同样保留
+    (void)gen->arena.release();
     
-    linker_.abandon();
+    return true;
+}
+
+bool SoLoader::runConstructors() {
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    auto* gen = current();
+    if (!gen) return false;
+    gen->linker.runConstructors();
+    return true;
+}
+
+std::string SoLoader::path() const {
+    EpochDomain::Guard guard;
+    auto* gen = current();
+    return gen ? gen->path : std::string();
+}
+
+bool SoLoader::reloadDependency(std::string_view name) {
+    // 与 unload/reload 串行；本身不进入读者区，才能在卸载旧版本前等待读者离开
+    std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+    auto* gen = current();
+    if (!gen) return false;
+    LoadedDep retired;
+    if (!gen->linker.reloadDependency(name, retired)) return false;
     
-    lib_path_.clear();
-    image_ = nullptr;
+    // 全局范围的缓存可能指向旧版本；主库导出不变。并发查找可能仍在读旧表，只撤下不释放
+    gen->symbol_caches[static_cast<size_t>(SymbolScope::Global)].invalidate();
     
+    // 新作用域已发布：等待仍可能在旧版本中查找或持有旧缓存条目的读者离开，再析构并卸载
+    EpochDomain::instance().synchronize();
+    gen->linker.retireDependency(retired);
     return true;
 }
 
-void* SoLoader::getSymbol(std::string_view name) {
-    if (!isLoaded()) return nullptr;
+void* SoLoader::lookupSymbol(Generation& gen, std::string_view name, uint32_t hash,
+                             SymbolScope scope) {
+    auto& cache = gen.symbol_caches[static_cast<size_t>(scope)];
+    void* addr = nullptr;
+    if (cache.find(name, hash, &addr)) return addr;
+    
+    if (scope == SymbolScope::Global) {
+        addr = gen.linker.resolveSymbol(name);
+    } else if (auto found = gen.image->findSymbolAddress(name, hash, nullptr)) {
+        addr = reinterpret_cast<void*>(*found);
+    }
+    
+    // 未找到的结果同样缓存（条数有上限）：库内未命中会依次查 GNU 哈希、ELF 哈希并线性扫描 .symtab，
+    // 完整作用域的未命中还要查系统库。库加载后导出集合不变
+    cache.insert(name, hash, addr);
+    return addr;
+}
+
+void* SoLoader::getSymbol(std::string_view name, SymbolScope scope) {
+    EpochDomain::Guard guard;
+    auto* gen = current();
+    if (!gen) return nullptr;
+    return lookupSymbol(*gen, name, gnuHash(name), scope);
+}
+
+bool SoLoader::bindSymbols(void* table, size_t table_size, const SymbolBinding* bindings,
+                           size_t count, std::vector<std::string_view>* missing,
+                           SymbolScope scope) {
+    // 整张表从同一版本解析，不会混入 reload 前后两个版本的符号
+    EpochDomain::Guard guard;
+    auto* gen = current();
+    if (!gen) return false;
+    
+    auto* bytes = static_cast<uint8_t*>(table);
+    std::string missing_names;
+    size_t missing_count = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        auto& binding = bindings[i];
+        if (binding.offset + sizeof(void*) > table_size) {
+            LOGE("Binding for %.*s is outside the table", 
+                 static_cast<int>(binding.name.size()), binding.name.data());
+            return false;
+        }
+        
+        void* addr = lookupSymbol(*gen, binding.name, binding.hash, scope);
+        memcpy(bytes + binding.offset, &addr, sizeof(addr));
+        
+        if (!addr && binding.required) {
+            if (missing) missing->push_back(binding.name);
+            if (missing_count++) missing_names += ", ";
+            missing_names += binding.name;
+        }
+    }
     
-    auto addr = image_->findSymbolAddress(name);
-    return addr ? reinterpret_cast<void*>(*addr) : nullptr;
+    if (missing_count) {
+        LOGE("Missing %zu required symbols in %s: %s", missing_count, 
+             gen->path.c_str(), missing_names.c_str());
+        return false;
+    }
+    return true;
 }
 
 } // namespace soloader
@@ -129,8 +321,22 @@ void* SoLoader::getSymbol(std::string_view name) {
 
 #include <cstdio>
 #include <cstring>
+#include <cstdlib>
 #include <stdexcept>
+#include <algorithm>
+#include <chrono>
 #include <pthread.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "batch_io.hpp"
+#include "search_path.hpp"
+#include "interpose.hpp"
+#include "dep_registry.hpp"
+#include "library_namespace.hpp"
+#include "plugin_loader.hpp"
+#include "system_symbols.hpp"
+#include "backtrace.hpp"
 
 // 测试结构体（与 test_lib.cpp 中定义一致）
 struct TestData {
@@ -421,6 +627,8 @@ static void run_exception_tests(soloader::SoLoader& loader) {
 // TLS 多线程测试
 static soloader::SoLoader* g_loader = nullptr;
 
+static void* g_private_lib = nullptr;  // main() 预先用 dlopen 加载的 libtest_private.so
+
 static void* thread_func(void* arg) {
     int thread_id = *static_cast<int*>(arg);
     printf("\n[Thread %d] Started\n", thread_id);
@@ -446,6 +654,59 @@ static void* thread_func(void* arg) {
     return nullptr;
 }
 
+struct TestLibApi {
+    int (*add_numbers)(int, int);
+    const char* (*get_greeting)(const char*);
+    int (*sum_array)(const int*, int);
+    void (*not_exported)();
+};
+
+static constexpr soloader::SymbolBinding kTestLibApi[] = {
+    SOLOADER_BIND(TestLibApi, add_numbers, "add_numbers"),
+    SOLOADER_BIND(TestLibApi, get_greeting, "get_greeting"),
+    SOLOADER_BIND(TestLibApi, sum_array, "sum_array"),
+    SOLOADER_BIND_OPTIONAL(TestLibApi, not_exported, "not_exported_symbol"),
+};
+
+static void run_binding_tests(soloader::SoLoader& loader) {
+    int passed = 0, failed = 0;
+    
+    TestLibApi api{};
+    std::vector<std::string_view> missing;
+    if (loader.bindSymbols(api, kTestLibApi, &missing) && missing.empty()) {
+        int values[] = {1, 2, 3, 4};
+        bool ok = api.add_numbers && api.add_numbers(2, 3) == 5 &&
+                  api.get_greeting && api.sum_array && api.sum_array(values, 4) == 10 &&
+                  !api.not_exported;
+        printf("  [%s] Required and optional symbols bound\n", ok ? "PASS" : "FAIL");
+        ok ? passed++ : failed++;
+    } else {
+        printf("  [FAIL] Binding failed (%zu missing)\n", missing.size());
+        failed++;
+    }
+    
+    // 必需符号缺失时一次性报告全部
+    static constexpr soloader::SymbolBinding kBroken[] = {
+        SOLOADER_BIND(TestLibApi, add_numbers, "add_numbers"),
+        SOLOADER_BIND(TestLibApi, get_greeting, "missing_symbol_a"),
+        SOLOADER_BIND(TestLibApi, sum_array, "missing_symbol_b"),
+    };
+    missing.clear();
+    bool bound = loader.bindSymbols(api, kBroken, &missing);
+    bool ok = !bound && missing.size() == 2 && api.add_numbers;
+    printf("  [%s] Missing required symbols reported together\n", ok ? "PASS" : "FAIL");
+    ok ? passed++ : failed++;
+    
+    printf("\n  绑定测试结果: %d passed, %d failed\n", passed, failed);
+}
+
+static int g_counting_mallocs = 0;
+
+static void* counting_malloc(size_t size) {
+    g_counting_mallocs++;
+    return malloc(size);
+}
+
 static void run_tests(soloader::SoLoader& loader) {
     printf("\n========== 开始测试 ==========\n\n");
     
@@ -572,10 +833,402 @@ static void run_tests(soloader::SoLoader& loader) {
     printf("\n--- 12. 异常测试 ---\n");
     run_exception_tests(loader);
     
+    // 13. 函数表批量绑定
+    printf("\n--- 13. 函数表批量绑定 ---\n");
+    run_binding_tests(loader);
+    
+    // 14. 完美哈希导出表
+    printf("\n--- 14. 完美哈希导出表 ---\n");
+    if (auto* index = loader.exportIndex()) {
+        auto& stats = index->stats();
+        printf("  %zu symbols, %zu buckets, %zu bytes, built in %.3f ms\n",
+               stats.symbols, stats.buckets, stats.bytes, stats.build_ms);
+        bool ok = loader.getSymbol("add_numbers") && loader.getSymbol("get_lib_info") &&
+                  !loader.getSymbol("not_exported_symbol");
+        printf("  [%s] Lookups through export index\n", ok ? "PASS" : "FAIL");
+    } else {
+        printf("  Export index not built\n");
+    }
+    
+    // 15. 导出符号枚举
+    printf("\n--- 15. 导出符号枚举 ---\n");
+    {
+        size_t total = 0;
+        for (auto sym : loader.exports()) {
+            (void)sym;
+            total++;
+        }
+        printf("  %zu exported symbols\n", total);
+        
+        std::string names;
+        for (auto sym : loader.exportsWithPrefix("tls_")) {
+            names += sym.name;
+            names += ' ';
+        }
+        bool ok = names == "tls_get_buffer tls_increment tls_set_buffer ";
+        printf("  [%s] Prefix query: %s\n", ok ? "PASS" : "FAIL", names.c_str());
+        
+        size_t matched = 0;
+        bool same = true;
+        loader.forEachExport("create_*_object", [&](std::string_view name, void* addr) {
+            matched++;
+            same = same && addr == loader.getSymbol(name);
+        });
+        ok = matched == 2 && same && loader.exportsWithPrefix("no_such_prefix_").empty();
+        printf("  [%s] Pattern query: %zu matches\n", ok ? "PASS" : "FAIL", matched);
+    }
+    
+    // 16. 符号替换表
+    printf("\n--- 16. 符号替换表 ---\n");
+    {
+        auto* hooked = loader.getSymbol("dl_iterate_phdr", soloader::SymbolScope::Global);
+        bool ok = hooked == reinterpret_cast<void*>(&soloader::BacktraceManager::customDlIteratePhdr);
+        printf("  [%s] dl_iterate_phdr bound to loader implementation\n", ok ? "PASS" : "FAIL");
+    }
+    
+    // 17. 专用 arena 分配器
+    printf("\n--- 17. 专用 arena 分配器 ---\n");
+    {
+        soloader::SoLoader arena_loader;
+        arena_loader.setArenaEnabled(true);
+        if (arena_loader.load(loader.path()) && arena_loader.arena()) {
+            auto alloc = arena_loader.getSymbol<void*(*)(size_t)>("allocate_buffer");
+            auto release = arena_loader.getSymbol<void(*)(void*)>("free_buffer");
+            auto create = arena_loader.getSymbol<void*(*)(int)>("create_test_object");
+            auto destroy = arena_loader.getSymbol<void(*)(void*)>("destroy_test_object");
+            
+            auto before = arena_loader.arena()->stats();
+            void* buf = alloc(100);
+            void* obj = create(7);
+            auto during = arena_loader.arena()->stats();
+            release(buf);
+            destroy(obj);
+            void* leaked = alloc(64);   // 由 unload 时整体回收
+            (void)leaked;
+            auto after = arena_loader.arena()->stats();
+            
+            bool ok = during.allocations >= before.allocations + 2 &&
+                      after.frees >= before.frees + 2 &&
+                      after.bytes_in_use > 0;
+            printf("  [%s] Plugin allocations served by arena (%zu allocs, %zu frees, peak %zu bytes)\n",
+                   ok ? "PASS" : "FAIL", after.allocations, after.frees, after.peak_bytes);
+            
+            // 退出线程的缓存块和未汇总计数在线程结束时归还 arena
+            std::thread worker([&] { release(alloc(100)); });
+            worker.join();
+            auto joined = arena_loader.arena()->stats();
+            printf("  [%s] Exited thread's cache returned to arena (%zu frees)\n",
+                   joined.frees == after.frees + 1 ? "PASS" : "FAIL", joined.frees);
+            arena_loader.unload();
+        } else {
+            printf("  [FAIL] Could not load library with arena\n");
+        }
+    }
+    
+    // 18. GOT 重绑定
+    printf("\n--- 18. GOT 重绑定 ---\n");
+    {
+        auto alloc = loader.getSymbol<void*(*)(size_t)>("allocate_buffer");
+        auto release = loader.getSymbol<void(*)(void*)>("free_buffer");
+        
+        size_t slots = loader.rebindImport("malloc", reinterpret_cast<void*>(&counting_malloc));
+        release(alloc(32));
+        int counted = g_counting_mallocs;
+        loader.rebindImport("malloc", reinterpret_cast<void*>(&malloc));
+        release(alloc(32));
+        
+        bool ok = slots > 0 && counted == 1 && g_counting_mallocs == 1 &&
+                  loader.rebindImport("not_imported_symbol", nullptr) == 0;
+        printf("  [%s] Rebound %zu malloc slots and restored them\n", ok ? "PASS" : "FAIL", slots);
+    }
+    
+    // 19. 依赖热替换
+    printf("\n--- 19. 依赖热替换 ---\n");
+    {
+        // 系统库和不存在的依赖被拒绝，库保持可用
+        bool ok = !loader.reloadDependency("libc.so") &&
+                  !loader.reloadDependency("not_a_dependency.so");
+        auto add = loader.getSymbol<int(*)(int, int)>("add_numbers");
+        ok = ok && add && add(2, 3) == 5;
+        printf("  [%s] Reload rejects non-manual dependencies\n", ok ? "PASS" : "FAIL");
+        
+        // 私有的 libtest_dep.so 副本可以热替换：新副本的计数从 1 开始，说明测试库的导入已改指新版本
+        soloader::SoLoader private_loader;
+        private_loader.setShareDependencies(false);
+        ok = private_loader.load(loader.path());
+        auto counter = private_loader.getSymbol<int(*)()>("dep_counter");
+        ok = ok && counter && counter() == 1 && counter() == 2;
+        ok = ok && private_loader.reloadDependency("libtest_dep.so") && counter() == 1;
+        printf("  [%s] Reloaded libtest_dep.so and re-patched its callers\n", ok ? "PASS" : "FAIL");
+    }
+    
+    // 20. 主库热重载
+    printf("\n--- 20. 主库热重载 ---\n");
+    {
+        // 重载期间读线程持续解析并调用符号，不应出现空指针或错误结果
+        std::atomic<bool> stop{false};
+        std::atomic<int> calls{0}, errors{0};
+        std::thread reader([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto add = loader.getSymbol<int(*)(int, int)>("add_numbers");
+                if (!add || add(2, 3) != 5) errors++;
+                calls++;
+            }
+        });
+        
+        auto before = loader.getSymbol("add_numbers");
+        std::string path = loader.path();
+        bool reloaded = loader.reload(path, std::chrono::milliseconds(50));
+        bool rejected = !loader.reload("/nonexistent/libmissing.so", std::chrono::milliseconds(0));
+        stop = true;
+        reader.join();
+        
+        auto after = loader.getSymbol("add_numbers");
+        bool ok = reloaded && rejected && errors == 0 && after && after != before &&
+                  loader.path() == path;
+        printf("  [%s] Reloaded %s with %d concurrent calls\n", ok ? "PASS" : "FAIL",
+               path.c_str(), calls.load());
+        
+        // 宽限期不阻塞调用方：旧版本留在待回收列表，由之后的生命周期调用或析构函数回收
+        auto start = std::chrono::steady_clock::now();
+        bool again = loader.reload(path, std::chrono::seconds(1));
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        ok = again && elapsed < std::chrono::seconds(1) && loader.collectRetired() >= 1;
+        printf("  [%s] Reload returned in %lld ms, old version retired after the grace period\n",
+               ok ? "PASS" : "FAIL",
+               static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()));
+    }
+    
+    // 21. 卸载与并发查找
+    printf("\n--- 21. 卸载与并发查找 ---\n");
+    {
+        // 读线程只解析不调用：卸载窗口内返回 nullptr，其余时间返回有效地址，不应访问已释放的镜像
+        std::atomic<bool> stop{false};
+        std::atomic<int> found{0}, not_found{0};
+        std::thread reader([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (loader.getSymbol("add_numbers", soloader::SymbolScope::Global)) {
+                    found++;
+                } else {
+                    not_found++;
+                }
+            }
+        });
+        
+        std::string path = loader.path();
+        bool ok = true;
+        for (int i = 0; i < 5 && ok; i++) {
+            ok = loader.unload() && loader.load(path);
+        }
+        stop = true;
+        reader.join();
+        
+        auto add = loader.getSymbol<int(*)(int, int)>("add_numbers");
+        ok = ok && add && add(2, 3) == 5;
+        printf("  [%s] 5 unload/load cycles, %d hits, %d misses\n", ok ? "PASS" : "FAIL",
+               found.load(), not_found.load());
+    }
+    
+    // 22. 共享依赖注册表
+    printf("\n--- 22. 共享依赖注册表 ---\n");
+    {
+        // 两个实例同时加载同一库互不影响：libtest_dep.so 复用第一个实例登记的副本，系统库不登记
+        auto& registry = soloader::DependencyRegistry::instance();
+        size_t before = registry.size();
+        soloader::SoLoader second;
+        bool ok = second.load(loader.path());
+        auto add = second.getSymbol<int(*)(int, int)>("add_numbers");
+        ok = ok && add && add(2, 3) == 5 && registry.size() == before;
+        ok = ok && second.unload() && registry.size() == before;
+        auto first_add = loader.getSymbol<int(*)(int, int)>("add_numbers");
+        ok = ok && first_add && first_add(2, 3) == 5;
+        printf("  [%s] Second instance loaded and unloaded independently (%zu shared)\n",
+               ok ? "PASS" : "FAIL", registry.size());
+    }
+    
+    // 23. 多库命名空间
+    printf("\n--- 23. 多库命名空间 ---\n");
+    {
+        soloader::LibraryNamespace ns;
+        std::string path = loader.path();
+        std::string name = path.substr(path.rfind('/') + 1);
+        
+        bool ok = !ns.getSymbol("add_numbers") && ns.load(path);
+        auto add = ns.getSymbol<int(*)(int, int)>("add_numbers");
+        ok = ok && add && add(2, 3) == 5;
+        ok = ok && ns.getSymbol(name, "add_numbers") == reinterpret_cast<void*>(add) &&
+             !ns.getSymbol("not_a_library.so", "add_numbers");
+        
+        // 重复加载同一路径跳过；作用域查找同样能解析系统库符号
+        ok = ok && ns.load(path) && ns.libraryCount() == 1 && ns.getSymbol("malloc");
+        
+        // 批中任一库失败时整批回滚，已加载的库不受影响
+        ok = ok && !ns.load("/nonexistent/libmissing.so") && ns.libraryCount() == 1 &&
+             ns.getSymbol("add_numbers") == reinterpret_cast<void*>(add);
+        ok = ok && ns.unload() && !ns.isLoaded() && !ns.getSymbol("add_numbers");
+        
+        soloader::LibraryNamespace first_batch;
+        ok = ok && !first_batch.load({path, "/nonexistent/libmissing.so"}) &&
+             !first_batch.isLoaded() && first_batch.libraryCount() == 0;
+        printf("  [%s] Namespace load, scoped lookup, rollback and unload\n", ok ? "PASS" : "FAIL");
+    }
+    
+    // 24. 并行批量加载
+    printf("\n--- 24. 并行批量加载 ---\n");
+    {
+        soloader::PluginLoader plugins;
+        std::string path = loader.path();
+        std::string name = path.substr(path.rfind('/') + 1);
+        soloader::PluginLoadOptions options;
+        options.threads = 2;
+        
+        // 失败的库不影响其余库；构造函数在全部链接完成后执行，私有副本的计数从 1 开始
+        bool ok = plugins.load({path, "/nonexistent/libmissing.so"}, options) == 1;
+        ok = ok && plugins.results().size() == 2 && plugins.results()[0].ok() &&
+             !plugins.results()[1].ok();
+        auto* plugin = plugins.find(name);
+        auto info = plugin ? plugin->getSymbol<const char*(*)()>("get_lib_info") : nullptr;
+        ok = ok && info && strstr(info(), "Init count: 1");
+        
+        // 已加载的路径跳过，之前失败的结果被移除
+        ok = ok && plugins.load({path}, options) == 0 && plugins.results().size() == 1;
+        
+        // 失败的路径可以重试：文件就位后再次加载成功
+        std::string retry = path.substr(0, path.rfind('/') + 1) + "libretry_plugin.so";
+        unlink(retry.c_str());
+        ok = ok && plugins.load({retry}, options) == 0;
+        if (FILE* in = fopen(path.c_str(), "rb")) {
+            if (FILE* out = fopen(retry.c_str(), "wb")) {
+                char buf[4096];
+                size_t n;
+                while ((n = fread(buf, 1, sizeof(buf), in)) > 0) fwrite(buf, 1, n, out);
+                fclose(out);
+            }
+            fclose(in);
+        }
+        ok = ok && plugins.load({retry}, options) == 1 && plugins.results().size() == 2 &&
+             plugins.find("libretry_plugin.so");
+        for (auto& result : plugins.results()) {
+            printf("  %s: load %lld us, init %lld us\n", result.path.c_str(),
+                   static_cast<long long>(result.load_time.count()),
+                   static_cast<long long>(result.init_time.count()));
+        }
+        plugins.unloadAll();
+        unlink(retry.c_str());
+        ok = ok && plugins.results().empty() && !plugins.find(name);
+        printf("  [%s] Parallel load, retry, deferred constructors and unload\n", ok ? "PASS" : "FAIL");
+    }
+    
+    // 25. 系统符号解析顺序
+    printf("\n--- 25. 系统符号解析顺序 ---\n");
+    {
+        // 全局组优先：libsigchain 等对 sigaction/signal 的覆盖不被依赖句柄中 libc 的定义绕过
+        auto& cache = soloader::SystemSymbolCache::instance();
+        void* libc = dlopen("libc.so", RTLD_NOW | RTLD_NOLOAD);
+        std::vector<void*> scope{libc};
+        void* expected = dlsym(RTLD_DEFAULT, "sigaction");
+        bool ok = expected && cache.resolve(scope, "sigaction") == expected;
+        std::vector<void*> out;
+        cache.resolveBatch(scope, {"sigaction", "signal"}, out);
+        ok = ok && out[0] == expected && out[1] == dlsym(RTLD_DEFAULT, "signal");
+        if (libc) dlclose(libc);
+        printf("  [%s] sigaction/signal resolve like the system linker\n", ok ? "PASS" : "FAIL");
+    }
+    
+    // 26. 深层依赖的 soname 回退
+    printf("\n--- 26. 深层依赖的 soname 回退 ---\n");
+    {
+        // libtest_dep.so（手动加载）依赖的 libtest_private.so 不在搜索路径中，只能按 soname 找到系统已加载的副本
+        auto dep_private = loader.getSymbol<int(*)()>("test_dep_private", soloader::SymbolScope::Global);
+        void* expected = g_private_lib ? dlsym(g_private_lib, "test_private_value") : nullptr;
+        bool ok = dep_private && dep_private() == 42 && expected &&
+                  loader.getSymbol("test_private_value", soloader::SymbolScope::Global) == expected;
+        printf("  [%s] Dependency reachable only by soname resolves to the system copy\n", ok ? "PASS" : "FAIL");
+    }
+    
     printf("\n========== 测试完成 ==========\n");
 }
 
+// 批量 I/O 基准：把目录中的所有 .so 当作一层依赖，按加载器的实际路径处理：
+// LibrarySearchPath 目录索引解析路径，再由 BatchIo 批量打开 + 读取，对比同步实现与 io_uring
+static int run_io_benchmark(const char* dir, int rounds) {
+    using soloader::BatchIo;
+    
+    std::vector<std::string> names;
+    if (DIR* d = opendir(dir)) {
+        while (auto* ent = readdir(d)) {
+            std::string name = ent->d_name;
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, ".so") == 0) {
+                names.push_back(name);
+            }
+        }
+        closedir(d);
+    }
+    std::sort(names.begin(), names.end());
+    if (names.empty()) {
+        printf("No .so files in %s\n", dir);
+        return 1;
+    }
+    
+    auto& search = soloader::LibrarySearchPath::instance();
+    search.setLibraryPath("");
+    search.setSearchPaths({dir});
+    
+    printf("I/O benchmark: %zu libraries in %s, %d rounds\n", names.size(), dir, rounds);
+    
+    const std::pair<BatchIo::Backend, const char*> backends[] = {
+        {BatchIo::Backend::Sync, "sync"},
+        {BatchIo::Backend::IoUring, "io_uring"},
+    };
+    for (auto& [backend, label] : backends) {
+        if (!BatchIo::instance().setBackend(backend)) {
+            printf("  %-8s unavailable\n", label);
+            continue;
+        }
+        
+        double resolve_us = 0, read_us = 0;
+        size_t bytes = 0;
+        for (int r = 0; r < rounds; r++) {
+            // 丢弃页缓存，使每轮都从存储读取（tmpfs 上无效果）
+            for (auto& name : names) {
+                int fd = open((std::string(dir) + "/" + name).c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd >= 0) {
+                    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                    close(fd);
+                }
+            }
+            
+            // 与 loadDependencies 相同：每次链接校验一次目录索引，路径解析在内存中完成
+            auto start = std::chrono::steady_clock::now();
+            search.refresh();
+            std::vector<std::string> paths;
+            std::string path;
+            for (auto& name : names) {
+                if (search.find(name, path)) paths.push_back(path);
+            }
+            auto mid = std::chrono::steady_clock::now();
+            std::vector<soloader::LoadContext> contexts;
+            BatchIo::instance().openAndRead(paths, contexts);
+            auto end = std::chrono::steady_clock::now();
+            
+            resolve_us += std::chrono::duration<double, std::micro>(mid - start).count();
+            read_us += std::chrono::duration<double, std::micro>(end - mid).count();
+            bytes = 0;
+            for (auto& ctx : contexts) {
+                if (ctx.isOpen()) bytes += ctx.fileSize();
+            }
+        }
+        printf("  %-8s resolve %8.1f us + open/read %10.1f us per round (%zu bytes read)\n",
+               label, resolve_us / rounds, read_us / rounds, bytes);
+    }
+    return 0;
+}
+
 int main(int argc, char** argv, char** envp) {
+    if (argc >= 3 && strcmp(argv[1], "--bench-io") == 0) {
+        return run_io_benchmark(argv[2], argc >= 4 ? atoi(argv[3]) : 10);
+    }
+    
     soloader::g_argc = argc;
     soloader::g_argv = argv;
     soloader::g_envp = envp;
@@ -585,6 +1238,7 @@ int main(int argc, char** argv, char** envp) {
     
     if (argc < 2) {
         printf("Usage: %s <library.so>\n", argv[0]);
+        printf("       %s --bench-io <dir> [rounds]\n", argv[0]);
         printf("\nExample:\n");
         printf("  %s /data/local/tmp/libtest_lib.so\n", argv[0]);
         return 1;
@@ -593,7 +1247,23 @@ int main(int argc, char** argv, char** envp) {
     const char* lib_path = argv[1];
     printf("Loading library: %s\n", lib_path);
     
+    // 测试库的依赖 libtest_dep.so 与其放在同一目录
+    std::string lib_dir(lib_path);
+    lib_dir = lib_dir.find('/') == std::string::npos ? "." : lib_dir.substr(0, lib_dir.rfind('/'));
+    const char* env_path = getenv("LD_LIBRARY_PATH");
+    soloader::LibrarySearchPath::instance().setLibraryPath(env_path ? lib_dir + ":" + env_path : lib_dir);
+    
+    // libtest_dep.so 的依赖放在搜索路径之外，先由系统链接器加载，SoLoader 按 soname 找到它
+    std::string private_path = lib_dir + "/private/libtest_private.so";
+    g_private_lib = dlopen(private_path.c_str(), RTLD_NOW);
+    if (!g_private_lib) {
+        printf("ERROR: Failed to dlopen %s: %s\n", private_path.c_str(), dlerror());
+        return 1;
+    }
+    
     soloader::SoLoader loader;
+    // 测试库导出较少，强制构建完美哈希导出表以覆盖该查找路径
+    loader.setExportIndexThreshold(1);
     if (!loader.load(lib_path)) {
         printf("ERROR: Failed to load library: %s\n", lib_path);
         return 1;
@@ -0,0 +1,90 @@
+// Modern C++17 SO Loader - Concurrent Symbol Cache Implementation (arm64 only)
+
+#include "symbol_cache.hpp"
+
+namespace soloader {
+
+static constexpr size_t kInitialCapacity = 64;
+static constexpr size_t kMaxMisses = 256;
+
+SymbolCache::Table::Table(size_t capacity)
+    : mask(capacity - 1), slots(new std::atomic<Entry*>[capacity]) {
+    for (size_t i = 0; i < capacity; i++) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+SymbolCache::SymbolCache() = default;
+
+SymbolCache::~SymbolCache() {
+    clear();
+}
+
+bool SymbolCache::find(std::string_view name, uint32_t hash, void** address) const {
+    Table* table = table_.load(std::memory_order_acquire);
+    if (!table) return false;
+
+    for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+        Entry* entry = table->slots[i].load(std::memory_order_acquire);
+        if (!entry) return false;
+        if (entry->hash == hash && entry->name == name) {
+            *address = entry->address;
+            return true;
+        }
+    }
+}
+
+void SymbolCache::place(Table* table, Entry* entry) {
+    for (size_t i = entry->hash & table->mask;; i = (i + 1) & table->mask) {
+        if (!table->slots[i].load(std::memory_order_relaxed)) {
+            table->slots[i].store(entry, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+void SymbolCache::insert(std::string_view name, uint32_t hash, void* address) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+
+    void* existing = nullptr;
+    if (find(name, hash, &existing)) return;
+    if (!address && misses_ >= kMaxMisses) return;
+
+    // 负载因子保持在 1/2 以下；扩容时先填满新表再发布，读者看到的总是完整的表
+    Table* table = table_.load(std::memory_order_relaxed);
+    size_t capacity = table ? table->mask + 1 : 0;
+    if ((entries_.size() + 1) * 2 > capacity) {
+        auto grown = std::make_unique<Table>(capacity ? capacity * 2 : kInitialCapacity);
+        for (auto& entry : entries_) {
+            place(grown.get(), entry.get());
+        }
+        table = grown.get();
+        tables_.push_back(std::move(grown));
+        table_.store(table, std::memory_order_release);
+    }
+
+    entries_.push_back(std::unique_ptr<Entry>(new Entry{hash, address, std::string(name)}));
+    place(table, entries_.back().get());
+    if (!address) misses_++;
+}
+
+void SymbolCache::invalidate() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    table_.store(nullptr, std::memory_order_release);
+    for (auto& entry : entries_) {
+        retired_.push_back(std::move(entry));
+    }
+    entries_.clear();
+    misses_ = 0;
+}
+
+void SymbolCache::clear() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    table_.store(nullptr, std::memory_order_release);
+    tables_.clear();
+    entries_.clear();
+    retired_.clear();
+    misses_ = 0;
+}
+
+} // namespace soloader
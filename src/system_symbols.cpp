@@ -0,0 +1,124 @@
+// Modern C++17 SO Loader - System Symbol Cache Implementation (arm64 only)
+
+#include "system_symbols.hpp"
+#include "log.hpp"
+#include <dlfcn.h>
+
+namespace soloader {
+
+// 第 0 级为 RTLD_DEFAULT（全局组：可执行文件、LD_PRELOAD 和 RTLD_GLOBAL 加载的库），之后是各依赖的句柄。
+// 与系统链接器一致，全局组的定义优先：预加载库和 libsigchain 的 sigaction/signal 覆盖 libc
+static void* scopeHandle(const std::vector<void*>& scope, size_t level) {
+    return level == 0 ? RTLD_DEFAULT : scope[level - 1];
+}
+
+SystemSymbolCache& SystemSymbolCache::instance() {
+    static SystemSymbolCache inst;
+    return inst;
+}
+
+void SystemSymbolCache::sync(uint64_t generation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation_ == generation) return;
+    if (!tables_.empty()) {
+        LOGD("Link map changed, dropping cached system symbols");
+    }
+    tables_.clear();
+    generation_ = generation;
+}
+
+void SystemSymbolCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tables_.clear();
+}
+
+void* SystemSymbolCache::resolve(const std::vector<void*>& scope, std::string_view name) {
+    // 单个名字不经批量路径：查找键复用线程本地缓冲，命中缓存时不分配内存
+    thread_local std::string key;
+    key.assign(name.data(), name.size());
+
+    for (size_t level = 0; level <= scope.size(); level++) {
+        void* handle = scopeHandle(scope, level);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& table = tables_[handle];
+            auto it = table.find(key);
+            if (it != table.end()) {
+                if (it->second.address) return it->second.address;
+                continue;
+            }
+        }
+
+        // 锁外调用 dlsym，结果（包括未找到）写回缓存
+        void* addr = dlsym(handle, key.c_str());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tables_[handle].emplace(key, Entry{addr});
+        }
+        if (addr) return addr;
+    }
+    return nullptr;
+}
+
+void SystemSymbolCache::resolveBatch(const std::vector<void*>& scope,
+                                     const std::vector<std::string_view>& names,
+                                     std::vector<void*>& out) {
+    out.assign(names.size(), nullptr);
+
+    // 待解析的名字（下标），每级作用域后移除已找到的
+    std::vector<size_t> pending(names.size());
+    for (size_t i = 0; i < names.size(); i++) pending[i] = i;
+
+    std::vector<std::string> keys(names.begin(), names.end());
+    std::vector<size_t> misses;
+    std::vector<void*> miss_addrs;
+
+    for (size_t level = 0; level <= scope.size() && !pending.empty(); level++) {
+        void* handle = scopeHandle(scope, level);
+        misses.clear();
+
+        // 1. 查缓存
+        std::vector<size_t> next;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& table = tables_[handle];
+            for (size_t i : pending) {
+                auto it = table.find(keys[i]);
+                if (it == table.end()) {
+                    misses.push_back(i);
+                } else if (it->second.address) {
+                    out[i] = it->second.address;
+                } else {
+                    next.push_back(i);
+                }
+            }
+        }
+        if (misses.empty()) {
+            pending = std::move(next);
+            continue;
+        }
+
+        // 2. 锁外调用 dlsym（可能持有系统链接器锁）
+        miss_addrs.resize(misses.size());
+        for (size_t k = 0; k < misses.size(); k++) {
+            miss_addrs[k] = dlsym(handle, keys[misses[k]].c_str());
+        }
+
+        // 3. 写回缓存（包括未找到）
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& table = tables_[handle];
+            for (size_t k = 0; k < misses.size(); k++) {
+                table.emplace(keys[misses[k]], Entry{miss_addrs[k]});
+                if (miss_addrs[k]) {
+                    out[misses[k]] = miss_addrs[k];
+                } else {
+                    next.push_back(misses[k]);
+                }
+            }
+        }
+        pending = std::move(next);
+    }
+}
+
+} // namespace soloader
@@ -42,6 +42,7 @@ TlsManager::TlsManager() {
 bool TlsManager::registerSegment(ElfImage* image) {
     if (!image->tlsSegment()) return true;
     
+    std::lock_guard<std::mutex> lock(mutex_);
     size_t mod_id = 0;
     for (size_t i = 1; i < MAX_TLS_MODULES; i++) {
         if (modules_[i].module_id == 0) {
@@ -80,6 +81,7 @@ bool TlsManager::registerSegment(ElfImage* image) {
 }
 
 void TlsManager::unregisterSegment(ElfImage* image) {
+    std::lock_guard<std::mutex> lock(mutex_);
     for (size_t i = 1; i < MAX_TLS_MODULES; i++) {
         if (modules_[i].owner == image) {
             modules_[i] = {};
@@ -89,6 +91,7 @@ void TlsManager::unregisterSegment(ElfImage* image) {
 }
 
 void* TlsManager::allocateBlock() {
+    std::lock_guard<std::mutex> lock(mutex_);
     size_t align = static_align_max_ ? static_align_max_ : sizeof(void*);
     // 限制对齐值不超过页大小（与原始实现一致）
     size_t pg_size = pageSize();
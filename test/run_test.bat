@@ -17,12 +17,14 @@ echo Device connected
 
 REM 创建设备目录
 echo Creating device directory...
-adb shell "mkdir -p %DEVICE_DIR%"
+adb shell "mkdir -p %DEVICE_DIR%/private"
 
 REM 推送文件
 echo Pushing files to device...
 adb push "%BUILD_DIR%\soloader_test" "%DEVICE_DIR%/"
 adb push "%BUILD_DIR%\test\libtest_lib.so" "%DEVICE_DIR%/"
+adb push "%BUILD_DIR%\test\libtest_dep.so" "%DEVICE_DIR%/"
+adb push "%BUILD_DIR%\test\private\libtest_private.so" "%DEVICE_DIR%/private/"
 
 REM 设置权限
 echo Setting permissions...
@@ -0,0 +1,18 @@
+// 测试用依赖库 - 由 test_lib 通过 DT_NEEDED 引用，用于验证手动加载依赖的热替换
+static int g_dep_calls = 0;
+
+extern "C" {
+
+int test_private_value();
+
+// 每个副本独立计数：重新加载后从 1 开始
+int test_dep_next() {
+    return ++g_dep_calls;
+}
+
+// 经私有目录中的 libtest_private.so 取值，验证深层依赖的 soname 回退
+int test_dep_private() {
+    return test_private_value();
+}
+
+} // extern "C"
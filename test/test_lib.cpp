@@ -27,9 +27,17 @@ static void lib_fini() {
     printf("[test_lib] Destructor called (call_count=%d)\n", g_call_count);
 }
 
+// ============== 依赖库 ==============
+extern "C" int test_dep_next();
+
 // ============== 导出函数 ==============
 extern "C" {
 
+// 经导入槽位调用依赖库（验证依赖热替换后的重绑定）
+int dep_counter() {
+    return test_dep_next();
+}
+
 // 基础函数测试
 void shared_function() {
     g_call_count++;
@@ -0,0 +1,8 @@
+// 测试用私有库 - 放在搜索路径之外，只能经系统链接器已加载的 soname 找到（test_dep 的 DT_NEEDED）
+extern "C" {
+
+int test_private_value() {
+    return 42;
+}
+
+} // extern "C"
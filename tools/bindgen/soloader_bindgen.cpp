@@ -0,0 +1,234 @@
+// Modern C++17 SO Loader - Binding Generator (host tool)
+//
+// 读取共享库的 .dynsym（复用 ElfImage 的解析代码），生成带编译期 gnuHash 的
+// 类型化函数表头文件，运行时通过 SoLoader::bindSymbols 一次完成绑定。
+//
+// 签名文件每行一项：`符号 = 函数类型`，符号后加 `?` 表示可选，`#` 开头为注释：
+//     plugin_init = int(int, char**)
+//     plugin_shutdown? = void()
+
+#include "elf_image.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace soloader;
+
+struct Options {
+    const char* input = nullptr;
+    const char* output = nullptr;
+    const char* signatures = nullptr;
+    std::string ns = "plugin";
+    std::string table = "Api";
+    std::string prefix;
+};
+
+struct Signature {
+    std::string type = "void()";
+    bool optional = false;
+};
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s <library.so> [-o out.hpp] [--namespace ns] [--struct Name]\n"
+            "       [--prefix p] [--signatures file]\n", argv0);
+}
+
+static std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return {};
+    size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+static bool loadSignatures(const char* path, std::map<std::string, Signature>& out) {
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "Cannot open signature file: %s\n", path);
+        return false;
+    }
+
+    std::string line;
+    int lineno = 0;
+    while (std::getline(in, line)) {
+        lineno++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            fprintf(stderr, "%s:%d: expected 'symbol = type'\n", path, lineno);
+            return false;
+        }
+
+        std::string name = trim(line.substr(0, eq));
+        Signature sig;
+        sig.type = trim(line.substr(eq + 1));
+        if (!name.empty() && name.back() == '?') {
+            sig.optional = true;
+            name = trim(name.substr(0, name.size() - 1));
+        }
+        if (name.empty() || sig.type.empty()) {
+            fprintf(stderr, "%s:%d: empty symbol or type\n", path, lineno);
+            return false;
+        }
+        out[name] = sig;
+    }
+    return true;
+}
+
+// 导出的函数符号（已定义、全局或弱绑定、默认/受保护可见性）
+static void collectExports(const ElfImage& image, const std::string& prefix,
+                           std::set<std::string>& out) {
+    auto* dynsym = image.dynsymStart();
+    auto* shdr = image.dynsymShdr();
+    auto* strtab = image.strtabStart();
+    if (!dynsym || !shdr || !strtab) return;
+
+    size_t count = shdr->sh_size / sizeof(ElfSym);
+    for (size_t i = 1; i < count; i++) {
+        auto& sym = dynsym[i];
+        if (sym.st_shndx == SHN_UNDEF || !sym.st_name) continue;
+
+        uint8_t bind = elf_st_bind(sym.st_info);
+        uint8_t type = elf_st_type(sym.st_info);
+        if (bind != STB_GLOBAL && bind != STB_WEAK) continue;
+        if (type != STT_FUNC && type != STT_GNU_IFUNC) continue;
+        if ((sym.st_other & 0x3) != STV_DEFAULT && (sym.st_other & 0x3) != STV_PROTECTED) continue;
+
+        std::string name = strtab + sym.st_name;
+        if (name.compare(0, prefix.size(), prefix) != 0) continue;
+        out.insert(std::move(name));
+    }
+}
+
+// 符号名转为合法的 C++ 标识符
+static std::string identifier(const std::string& name) {
+    std::string id;
+    for (char c : name) {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        id.push_back(ok ? c : '_');
+    }
+    if (id.empty() || (id[0] >= '0' && id[0] <= '9')) id.insert(0, "_");
+    return id;
+}
+
+static void emit(FILE* out, const Options& opts, const std::vector<std::string>& names,
+                 const std::map<std::string, Signature>& sigs) {
+    auto sigOf = [&](const std::string& name) {
+        auto it = sigs.find(name);
+        return it != sigs.end() ? it->second : Signature{};
+    };
+
+    const char* base = strrchr(opts.input, '/');
+    base = base ? base + 1 : opts.input;
+
+    fprintf(out, "// Generated by soloader_bindgen from %s. Do not edit.\n", base);
+    fprintf(out, "#pragma once\n\n");
+    fprintf(out, "#include \"soloader.hpp\"\n\n");
+    fprintf(out, "namespace %s {\n\n", opts.ns.c_str());
+
+    fprintf(out, "// 符号哈希（gnuHash，生成时计算）\n");
+    for (auto& name : names) {
+        fprintf(out, "inline constexpr uint32_t kHash_%s = 0x%08xu;\n",
+                identifier(name).c_str(), gnuHash(name));
+    }
+
+    fprintf(out, "\n// 函数类型\n");
+    for (auto& name : names) {
+        fprintf(out, "using %s_fn = %s;\n", identifier(name).c_str(), sigOf(name).type.c_str());
+    }
+
+    fprintf(out, "\nstruct %s {\n", opts.table.c_str());
+    for (auto& name : names) {
+        auto id = identifier(name);
+        fprintf(out, "    %s_fn* %s;\n", id.c_str(), id.c_str());
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "inline constexpr soloader::SymbolBinding k%sBindings[] = {\n", opts.table.c_str());
+    for (auto& name : names) {
+        auto id = identifier(name);
+        fprintf(out, "    {\"%s\", offsetof(%s, %s), kHash_%s, %s},\n", name.c_str(),
+                opts.table.c_str(), id.c_str(), id.c_str(), sigOf(name).optional ? "false" : "true");
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "// 绑定整张函数表，缺失的必需符号写入 missing\n");
+    int indent = static_cast<int>(strlen("inline bool bind(") + opts.table.size());
+    fprintf(out, "inline bool bind%s(soloader::SoLoader& loader, %s& table,\n"
+                 "%*sstd::vector<std::string_view>* missing = nullptr) {\n",
+            opts.table.c_str(), opts.table.c_str(), indent, "");
+    fprintf(out, "    return loader.bindSymbols(table, k%sBindings, missing);\n", opts.table.c_str());
+    fprintf(out, "}\n\n");
+    fprintf(out, "} // namespace %s\n", opts.ns.c_str());
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; i++) {
+        auto arg = [&](const char* flag) {
+            if (strcmp(argv[i], flag) != 0) return false;
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Missing value for %s\n", flag);
+                exit(2);
+            }
+            return true;
+        };
+        if (arg("-o")) opts.output = argv[++i];
+        else if (arg("--namespace")) opts.ns = argv[++i];
+        else if (arg("--struct")) opts.table = argv[++i];
+        else if (arg("--prefix")) opts.prefix = argv[++i];
+        else if (arg("--signatures")) opts.signatures = argv[++i];
+        else if (argv[i][0] == '-') { usage(argv[0]); return 2; }
+        else opts.input = argv[i];
+    }
+    if (!opts.input) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    auto image = ElfImage::parseFile(opts.input);
+    if (!image) {
+        fprintf(stderr, "Failed to parse %s\n", opts.input);
+        return 1;
+    }
+
+    std::set<std::string> exports;
+    collectExports(*image, opts.prefix, exports);
+
+    // 有签名文件时只生成其中列出的符号；库中缺失的仍然生成，运行时由绑定报告
+    std::map<std::string, Signature> sigs;
+    std::vector<std::string> names;
+    if (opts.signatures) {
+        if (!loadSignatures(opts.signatures, sigs)) return 1;
+        for (auto& [name, sig] : sigs) {
+            if (!exports.count(name)) {
+                fprintf(stderr, "warning: %s is not exported by %s\n", name.c_str(), opts.input);
+            }
+            names.push_back(name);
+        }
+    } else {
+        names.assign(exports.begin(), exports.end());
+    }
+
+    if (names.empty()) {
+        fprintf(stderr, "No exported functions to bind in %s\n", opts.input);
+        return 1;
+    }
+
+    FILE* out = opts.output ? fopen(opts.output, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Cannot write %s: %s\n", opts.output, strerror(errno));
+        return 1;
+    }
+    emit(out, opts, names, sigs);
+    if (out != stdout) fclose(out);
+
+    fprintf(stderr, "Generated %zu bindings from %s\n", names.size(), opts.input);
+    return 0;
+}